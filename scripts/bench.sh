@@ -3,25 +3,28 @@ thread_count=1
 memory_size="2g"
 warmup=10
 runtime=60
+sinks="discard aos soa"
+# one json file per sink, compare two directories with ./bench --compare old/x.json,new/x.json
+results_dir="${RESULTS_DIR:-results}"
 
-set -x
+# every format is generated once per sink, its parsers run one after another on the same input
+parsers="native,flatbuf,protobuf,avro,svb"
+parsers+=",msgpack,msgpackfast,cbor,cborfast"
+parsers+=",csvstd,csvfastfloat,csvfastfloatcustom,csvbenstrasser,csvsimd"
+parsers+=",rapidjson,rapidjsoninsitu,rapidjsonsax"
+parsers+=",simdjson,simdjsonec,simdjsonece,simdjsonu,jsonfastpath,simdjsonooo,simdjsonmany"
 
-./bench -t$thread_count -m$memory_size -pnative -w$warmup -i$runtime
-./bench -t$thread_count -m$memory_size -pflatbuf -w$warmup -i$runtime
-./bench -t$thread_count -m$memory_size -pprotobuf -w$warmup -i$runtime
-./bench -t$thread_count -m$memory_size -pavro -w$warmup -i$runtime
+mkdir -p "$results_dir"
 
-./bench -t$thread_count -m$memory_size -pcsvstd -w$warmup -i$runtime
-./bench -t$thread_count -m$memory_size -pcsvfastfloat -w$warmup -i$runtime
-./bench -t$thread_count -m$memory_size -pcsvfastfloatcustom -w$warmup -i$runtime
-./bench -t$thread_count -m$memory_size -pcsvbenstrasser -w$warmup -i$runtime
+for sink in $sinks; do
+    (set -x; ./bench -t$thread_count -m$memory_size -p"$parsers" -w$warmup -i$runtime --sink "$sink" \
+        --output json --output-file "$results_dir/$sink.json")
+done
 
-./bench -t$thread_count -m$memory_size -prapidjson -w$warmup -i$runtime
-./bench -t$thread_count -m$memory_size -prapidjsoninsitu -w$warmup -i$runtime
-./bench -t$thread_count -m$memory_size -prapidjsonsax -w$warmup -i$runtime
-
-./bench -t$thread_count -m$memory_size -psimdjson -w$warmup -i$runtime
-./bench -t$thread_count -m$memory_size -psimdjsonec -w$warmup -i$runtime
-./bench -t$thread_count -m$memory_size -psimdjsonece -w$warmup -i$runtime
-./bench -t$thread_count -m$memory_size -psimdjsonu -w$warmup -i$runtime
-./bench -t$thread_count -m$memory_size -psimdjsonooo -w$warmup -i$runtime
+# per-tuple cost of columnar record batches as their size varies, next to the row formats above
+for batch in 16 256 4096 65536; do
+    for sink in $sinks; do
+        (set -x; ./bench -t$thread_count -m$memory_size -pcolumnar --record-batch "$batch" -w$warmup \
+            -i$runtime --sink "$sink" --output json --output-file "$results_dir/columnar-$batch-$sink.json")
+    done
+done
@@ -81,5 +81,8 @@ IMPL_VISIBILITY bool parse_avro(const std::byte* __restrict__ read_ptr,
 }
 
 // clang-format off
-template void generate_tuples<serialize_avro>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, std::mutex* mutex);
-template void parse_tuples<parse_avro>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
+template void generate_tuples<serialize_avro>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_tuples<parse_avro>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+template void serialize_tuples<serialize_avro>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_avro, parse_avro>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
@@ -2,10 +2,20 @@
 #include <simdjson.h>
 #include <cxxopts.hpp>
 
+#include <array>
 #include <atomic>
+#include <cctype>
+#include <charconv>
 #include <chrono>
+#include <cstdio>
 #include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <set>
+#include <span>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <tuple>
 #include <utility>
@@ -13,179 +23,647 @@
 
 #include "avro.hpp"
 #include "bench.hpp"
+#include "cbor.hpp"
+#include "columnar.hpp"
+#include "compression.hpp"
 #include "csv.hpp"
+#include "csv_simd.hpp"
+#include "dataset.hpp"
 #include "flatbuffer.hpp"
+#include "ingest.hpp"
 #include "json.hpp"
+#include "kernels.hpp"
+#include "msgpack.hpp"
 #include "native.hpp"
+#include "perf.hpp"
 #include "protobuf.hpp"
+#include "results.hpp"
+#include "schema.hpp"
+#include "svb.hpp"
+#include "topology.hpp"
 
 using std::string_literals::operator""s;  // NOLINT(misc-unused-using-decls): It _is_ used.
+using std::string_view_literals::operator""sv;  // NOLINT(misc-unused-using-decls): It _is_ used.
 
-std::tuple<double, double, double> mean_stddev_99error_from_samples(
-    const std::vector<double>& samples) {
-    const double sum = std::accumulate(begin(samples), end(samples), 0.0);
-    const double mean = sum / static_cast<double>(samples.size());
+using GeneratorFunc = void (*)(std::vector<std::byte>*,
+                               size_t,
+                               std::vector<tuple_size_t>*,
+                               const GeneratorOptions&);
+enum class NumaMode { off, replicate, partition };
+enum class IngestMode { memory, socket, file };
+enum class BenchMode { parse, serialize, roundtrip };
 
-    const double squared_error_sum =
-        std::accumulate(begin(samples), end(samples), 0.0, [&](double acc, double sample) {
-            return acc + (sample - mean) * (sample - mean);
-        });
+using ParserRunnerFunc =
+    void (*)(ThreadResult*, const DatasetView&, const ParseOptions&, const std::atomic<bool>&);
+using TupleRunnerFunc = void (*)(ThreadResult*,
+                                 std::span<const NativeTuple>,
+                                 const ParseOptions&,
+                                 const std::atomic<bool>&);
+
+struct BenchEntry {
+    std::string_view format;  // name of the serialized format, parsers with equal names share input
+    GeneratorFunc generate;
+    ParserRunnerFunc parse;
+    TupleRunnerFunc serialize;  // serializer of the format, mostly the same for all its parsers
+    TupleRunnerFunc roundtrip;  // serializer and parser
+    bool batched = false;       // parses whole runs at once (parse_tuple_batches)
+    bool schema_tuples = false;  // tuples of a wider schema: plain parse runs only (schema.hpp)
+    bool speculative = false;    // fast path with a generic fallback, reports its hit rate
+    bool record_batches = false;  // columnar record batches: plain parse runs only (columnar.hpp)
+};
 
-    const double variance = squared_error_sum / static_cast<double>(samples.size() - 1);
-    const double std_dev = sqrt(variance);
+std::vector<std::string> split_comma_list(const std::string& list) {
+    std::vector<std::string> items;
+    size_t position = 0;
+    while (position <= list.size()) {
+        const size_t comma = std::min(list.find(',', position), list.size());
+        items.push_back(list.substr(position, comma - position));
+        position = comma + 1;
+    }
+    return items;
+}
 
-    // 99% => z* = 2.58
-    const double error = 2.58 * std_dev / sqrt(static_cast<double>(samples.size()));
+// csv-lines dialects are named by their --csv-delimiter and --csv-quoting, e.g. ",/none" or
+// "tab/text", in the results and in dataset files.
+constexpr std::array<std::pair<std::string_view, CsvQuoting>, 3> csv_quoting_names{{
+    {"none", CsvQuoting::none},
+    {"text", CsvQuoting::text},
+    {"all", CsvQuoting::all},
+}};
 
-    return std::make_tuple(mean, std_dev, error);
+std::optional<CsvDialect> parse_csv_dialect(std::string_view delimiter_name,
+                                            std::string_view quoting_name) {
+    const auto quoting_it =
+        std::find_if(begin(csv_quoting_names), end(csv_quoting_names),
+                     [&](const auto& item) { return item.first == quoting_name; });
+    const std::string_view delimiter = delimiter_name == "tab" ? "\t" : delimiter_name;
+    // Must not be part of a number, a hex string or a line ending.
+    if (quoting_it == end(csv_quoting_names) || delimiter.size() != 1 ||
+        std::isalnum(static_cast<unsigned char>(delimiter[0])) != 0 ||
+        delimiter.find_first_of("\"\n\r.+-") != std::string_view::npos) {
+        return std::nullopt;
+    }
+    CsvDialect dialect;
+    dialect.delimiter = delimiter[0];
+    dialect.quoting = quoting_it->second;
+    return dialect;
 }
 
-int main(int argc, char** argv) {
-    /*
-     * Command Line Arguments
-     */
+std::string csv_dialect_name(const CsvDialect& dialect) {
+    const auto quoting_it =
+        std::find_if(begin(csv_quoting_names), end(csv_quoting_names),
+                     [&](const auto& item) { return item.second == dialect.quoting; });
+    return fmt::format("{}/{}",
+                       dialect.delimiter == '\t' ? "tab" : std::string(1, dialect.delimiter),
+                       quoting_it->first);
+}
 
-    cxxopts::Options options("Parser Benchmark",
-                             "Benchmark parsing performance of different data formats and parsers");
-    // clang-format off
-    options.add_options()
-        ("m,memory", "How much memory to use for input tuples. Supported suffixed: k, m, g, t", cxxopts::value<std::string>())
-        ("t,threads", "How many threads to use for parsing tuples.", cxxopts::value<size_t>())
-        ("p,parser", "Parser to use", cxxopts::value<std::string>())
-        ("w,warmup", "Seconds to wait for warmup", cxxopts::value<size_t>()->default_value("10"))
-        ("i,iterations", "Seconds to measure", cxxopts::value<size_t>()->default_value("30"))
-        ("h,help", "Print usage");
-    // clang-format on
+// Settings shared by all runs of this process.
+struct BenchSettings {
+    BenchMode mode;
+    size_t warmup_seconds;
+    size_t measure_seconds;
+    ParseOptions parse_options;
+    NumaMode numa_mode;
+    CpuTopology topology;
+    std::vector<size_t> pin_order;  // empty if threads are not pinned
+    bool use_perf;
+    size_t pipeline_chunk_tuples;  // 0 if parsers read the input directly
+    size_t pipeline_depth;
+    IngestMode ingest_mode;
+    ReceiverKind receiver_kind;
+    size_t ingest_buffer_size;
+    size_t io_depth;
+    bool direct_io;
+    Codec codec;
+    size_t compress_block_size;
+    int compress_level;
+    WorkloadProfile workload;
+    // as given on the command line, for reports
+    std::string workload_name;  // profile/float format
+    std::string mode_name;
+    std::string sink_name;
+    std::string numa_name;
+    std::string pin_name;
+    std::string ingest_name;
+    std::string compress_name;
+    std::string csv_dialect_name;  // delimiter/quoting of the csv-lines format
+    std::string isa_name;          // level of the dispatched kernels
+    size_t record_batch_tuples;    // --record-batch, when generating columnar datasets
+};
 
-    const auto arguments = options.parse(argc, argv);
+// Input of one format as the parser threads see it: one view per NUMA node, each either backed by
+// a node-local copy or by the generated / mapped dataset.
+struct PlacedInput {
+    size_t numa_nodes = 1;
+    std::vector<NodeLocalDataset> node_datasets;
+    std::vector<DatasetView> node_views;
+    // of the whole dataset, the partitions of the nodes add up to this
+    size_t memory_size = 0;
+    size_t tuple_count = 0;
+    uint64_t seed = 0;
+    // dataset file the tuples were mapped from or written to, for file ingest
+    std::string dataset_path;
+    uint64_t dataset_memory_offset = 0;
+    // the tuples of the dataset before serialization, for --mode serialize / roundtrip
+    std::vector<NativeTuple> native_tuples;
+    // blocks of the dataset for --compress
+    CompressedDataset compressed;
+};
 
-    if (arguments.count("help") != 0) {
-        fmt::print("{}\n", options.help());
-        exit(0);  // NOLINT(concurrency-mt-unsafe)
+PlacedInput place_input(const DatasetView& dataset, uint64_t seed, const BenchSettings& settings) {
+    PlacedInput input;
+    input.numa_nodes = settings.numa_mode == NumaMode::off ? 1 : numa_node_count();
+    input.node_views.assign(input.numa_nodes, dataset);
+    input.memory_size = dataset.memory.size();
+    input.tuple_count = dataset.tuple_sizes.size();
+    input.seed = seed;
+
+    if (settings.numa_mode == NumaMode::off) {
+        return input;
     }
 
-    size_t suffix_position{};
-    const auto memory_bytes_string = arguments["memory"].as<std::string>();
-    uint64_t memory_bytes = std::stoll(memory_bytes_string, &suffix_position, 0);
-    if (suffix_position == memory_bytes_string.length() - 1) {
-        const char suffix = static_cast<char>(
-            std::tolower(static_cast<unsigned char>(memory_bytes_string.at(suffix_position))));
-        const std::map multiplicators{
-            std::make_pair('k', 1000ULL),
-            std::make_pair('m', 1000ULL * 1000),
-            std::make_pair('g', 1000ULL * 1000 * 1000),
-            std::make_pair('t', 1000ULL * 1000 * 1000 * 1000),
-        };
-        const auto it = multiplicators.find(suffix);
-        if (it == multiplicators.end()) {
-            fmt::print(stderr, "Invalid argument for memory: {}.\n", memory_bytes_string);
-            exit(1);  // NOLINT(concurrency-mt-unsafe)
-        }
-        memory_bytes *= it->second;
-    } else if (suffix_position < memory_bytes_string.length() - 1) {
-        fmt::print(stderr, "Invalid argument for memory: {}.\nAllowed suffixes: k, m, g, t.",
-                   memory_bytes_string);
+    if (!numa_supported()) {
+        fmt::print(stderr, "\nWARNING\nNUMA is not available, using a single node.\n\n");
+    }
+    const size_t numa_nodes = input.numa_nodes;
+    const size_t tuple_count = input.tuple_count;
+    if (settings.numa_mode == NumaMode::partition && tuple_count < numa_nodes) {
+        fmt::print(stderr, "Partitioning over {} nodes needs at least one tuple per node.\n",
+                   numa_nodes);
         exit(1);  // NOLINT(concurrency-mt-unsafe)
     }
 
-    const size_t thread_count = arguments["threads"].as<size_t>();
-    const size_t warmup_seconds = arguments["warmup"].as<size_t>();
-    const size_t measure_seconds = arguments["iterations"].as<size_t>();
+    const auto timestamp = std::chrono::high_resolution_clock::now();
+    input.node_datasets.reserve(numa_nodes);
+    for (size_t node = 0; node < numa_nodes; ++node) {
+        const DatasetView source =
+            settings.numa_mode == NumaMode::replicate
+                ? dataset
+                : slice_dataset(dataset, tuple_count * node / numa_nodes,
+                                tuple_count * (node + 1) / numa_nodes);
+        // Copy on the target node so that the copy itself runs at local write bandwidth.
+        std::thread([&] {
+            bind_current_thread_to_numa_node(node);
+            input.node_datasets.emplace_back(source, node);
+        }).join();
+        input.node_views[node] = input.node_datasets[node].view();
+    }
 
-    // clang-format off
-    const std::map generator_parser_map{
-        std::make_pair("native"s, std::make_tuple(generate_tuples<serialize_native>, parse_tuples<parse_native>)),
-
-        std::make_pair("rapidjson"s, std::make_tuple(generate_tuples<serialize_json>, parse_tuples<parse_rapidjson>)),
-        std::make_pair("rapidjsoninsitu"s, std::make_tuple(generate_tuples<serialize_json>, parse_tuples<parse_rapidjson_insitu>)),
-        std::make_pair("rapidjsonsax"s, std::make_tuple(generate_tuples<serialize_json>, parse_tuples<parse_rapidjson_sax>)),
-
-        std::make_pair("simdjson"s, std::make_tuple(generate_tuples<serialize_json>, parse_tuples<parse_simdjson>)),
-        std::make_pair("simdjsonec"s, std::make_tuple(generate_tuples<serialize_json>, parse_tuples<parse_simdjson_error_codes>)),
-        std::make_pair("simdjsonece"s, std::make_tuple(generate_tuples<serialize_json>, parse_tuples<parse_simdjson_error_codes_early>)),
-        std::make_pair("simdjsonu"s, std::make_tuple(generate_tuples<serialize_json>, parse_tuples<parse_simdjson_unescaped>)),
-        std::make_pair("simdjsonooo"s, std::make_tuple(generate_tuples<serialize_json>, parse_tuples<parse_simdjson_out_of_order>)),
-
-        std::make_pair("flatbuf"s, std::make_tuple(generate_tuples<serialize_flatbuffer>, parse_tuples<parse_flatbuffer>)),
-        std::make_pair("protobuf"s, std::make_tuple(generate_tuples<serialize_protobuf>, parse_tuples<parse_protobuf>)),
-        std::make_pair("avro"s, std::make_tuple(generate_tuples<serialize_avro>, parse_tuples<parse_avro>)),
-
-        std::make_pair("csvstd"s, std::make_tuple(generate_tuples<serialize_csv>, parse_tuples<parse_csv_std>)),
-        std::make_pair("csvfastfloat"s, std::make_tuple(generate_tuples<serialize_csv>, parse_tuples<parse_csv_fast_float>)),
-        std::make_pair("csvfastfloatcustom"s, std::make_tuple(generate_tuples<serialize_csv>, parse_tuples<parse_csv_fast_float_custom>)),
-        std::make_pair("csvbenstrasser"s, std::make_tuple(generate_tuples<serialize_csv>, parse_tuples<parse_csv_benstrasser>)),
-    };
-    // clang-format on
+    const std::chrono::duration<double> elapsed_seconds =
+        std::chrono::high_resolution_clock::now() - timestamp;
+    fmt::print(stderr, "Placed input on {} NUMA nodes ({}) in {}s.\n", numa_nodes,
+               settings.numa_name, elapsed_seconds.count());
+    return input;
+}
 
-    const auto it = generator_parser_map.find(arguments["parser"].as<std::string>());
-    if (it == generator_parser_map.end()) {
-        fmt::print(stderr, "Invalid argument for parser: {}.\n",
-                   arguments["parser"].as<std::string>());
-        exit(1);  // NOLINT(concurrency-mt-unsafe)
+// Splits the dataset into views of chunk_tuples consecutive tuples, the last one may be shorter.
+std::vector<DatasetView> split_into_chunks(const DatasetView& dataset, size_t chunk_tuples) {
+    std::vector<DatasetView> chunks;
+    size_t offset = 0;
+    for (size_t first = 0; first < dataset.tuple_sizes.size(); first += chunk_tuples) {
+        const auto sizes = dataset.tuple_sizes.subspan(
+            first, std::min(chunk_tuples, dataset.tuple_sizes.size() - first));
+        const size_t bytes = std::accumulate(begin(sizes), end(sizes), size_t{0});
+        chunks.push_back({dataset.memory.subspan(offset, bytes), sizes});
+        offset += bytes;
     }
+    return chunks;
+}
 
-    if (simdjson::builtin_implementation()->name() != "haswell") {
-        fmt::print("\nWARNING\nsimdjson implementation: {} (should be haswell)\n\n",
-                   simdjson::builtin_implementation()->name());
-    }
+// Cuts the dataset into blocks of whole tuples of at most block_size bytes (or a single larger
+// tuple) and compresses every block on its own.
+CompressedDataset compress_dataset(const DatasetView& dataset,
+                                   Codec codec,
+                                   size_t block_size,
+                                   int level) {
+    CompressedDataset compressed;
+    compressed.codec = codec;
+    compressed.raw_size = dataset.memory.size();
+    size_t raw_offset = 0;
+    size_t first_tuple = 0;
+    while (first_tuple < dataset.tuple_sizes.size()) {
+        size_t raw_size = dataset.tuple_sizes[first_tuple];
+        size_t tuple_count = 1;
+        while (first_tuple + tuple_count < dataset.tuple_sizes.size() &&
+               raw_size + dataset.tuple_sizes[first_tuple + tuple_count] <= block_size) {
+            raw_size += dataset.tuple_sizes[first_tuple + tuple_count];
+            ++tuple_count;
+        }
 
-    const auto [generator_func, parser_func] = it->second;
+        const size_t offset = compressed.memory.size();
+        compress_block(codec, level, dataset.memory.subspan(raw_offset, raw_size),
+                       &compressed.memory);
+        compressed.blocks.push_back(
+            {offset, compressed.memory.size() - offset, raw_size, first_tuple, tuple_count});
+        compressed.max_block_raw_size = std::max(compressed.max_block_raw_size, raw_size);
 
-    /*
-     * Input Data Generation
-     */
-    std::vector<std::byte> memory;
-    std::vector<tuple_size_t> tuple_sizes;
-    memory.reserve(memory_bytes + 1024);
-    tuple_sizes.reserve(memory_bytes / 64);
+        raw_offset += raw_size;
+        first_tuple += tuple_count;
+    }
+    compressed.memory.shrink_to_fit();
+    return compressed;
+}
 
-    {
-        auto gen_thread_count = std::max(1U, std::thread::hardware_concurrency() - 1);
+// Producer and consumer side of pipeline mode. Occupancy is sampled every
+// OCCUPANCY_SAMPLE_INTERVAL queue operations, reading the other side's index is not free.
+constexpr size_t OCCUPANCY_SAMPLE_INTERVAL = 16;
+struct PipelineCounters {
+    // TSC ticks the producer found all chunk queues full
+    alignas(cacheline_size) std::atomic<uint64_t> producer_wait_cycles = 0;
+    std::atomic<uint64_t> chunk_occupancy_sum = 0;
+    std::atomic<uint64_t> chunk_occupancy_samples = 0;
+    // TSC ticks the consumer found all batch queues empty
+    alignas(cacheline_size) std::atomic<uint64_t> consumer_wait_cycles = 0;
+    std::atomic<uint64_t> batch_occupancy_sum = 0;
+    std::atomic<uint64_t> batch_occupancy_samples = 0;
+};
 
-        fmt::print("Generating tuples for {} B of memory using {} threads.\n", memory_bytes,
-                   gen_thread_count);
-        const auto timestamp = std::chrono::high_resolution_clock::now();
+// Hands every lane the chunks of its input in order, starting over at the end. Lanes with a full
+// queue are skipped, so faster parsers get more chunks.
+void run_pipeline_producer(const std::vector<std::vector<DatasetView>>& node_chunks,
+                           const std::vector<size_t>& lane_nodes,
+                           const std::vector<std::unique_ptr<PipelineLane>>& lanes,
+                           PipelineCounters* counters,
+                           const std::atomic<bool>& stop_flag) {
+    std::vector<size_t> next_chunk(lanes.size());
+    // Counts push attempts, not pushes, so full queues are sampled at the same rate as others
+    // instead of on every spin until the next push.
+    size_t attempts = 0;
+    SpinWait spin;
+    while (!stop_flag.load(std::memory_order_relaxed)) {
+        bool pushed = false;
+        for (size_t lane = 0; lane < lanes.size(); ++lane) {
+            SpscRing<DatasetView>& queue = lanes[lane]->chunks;
+            const auto& chunks = node_chunks[lane_nodes[lane]];
+            if (attempts++ % OCCUPANCY_SAMPLE_INTERVAL == 0) {
+                counters->chunk_occupancy_sum.fetch_add(queue.size(), std::memory_order_relaxed);
+                counters->chunk_occupancy_samples.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (queue.try_push(chunks[next_chunk[lane]])) {
+                next_chunk[lane] = (next_chunk[lane] + 1) % chunks.size();
+                pushed = true;
+            }
+        }
+        if (pushed) {
+            counters->producer_wait_cycles.fetch_add(spin.done(), std::memory_order_relaxed);
+        } else {
+            spin.wait();
+        }
+    }
+}
+
+// Drains the batches of all lanes round robin and reads every tuple, like a downstream operator
+// would. Throughput is counted here, per lane, so it is end-to-end.
+void run_pipeline_consumer(const std::vector<std::unique_ptr<PipelineLane>>& lanes,
+                           std::vector<ThreadResult>* lane_results,
+                           PipelineCounters* counters,
+                           const std::atomic<bool>& stop_flag) {
+    uint64_t checksum = 0;
+    size_t pops = 0;
+    SpinWait spin;
+    while (!stop_flag.load(std::memory_order_relaxed)) {
+        bool popped = false;
+        for (size_t lane = 0; lane < lanes.size(); ++lane) {
+            TupleBatch* batch = nullptr;
+            if (!lanes[lane]->filled.try_pop(&batch)) {
+                continue;
+            }
+            if (pops++ % OCCUPANCY_SAMPLE_INTERVAL == 0) {
+                // including the batch just taken
+                counters->batch_occupancy_sum.fetch_add(lanes[lane]->filled.size() + 1,
+                                                        std::memory_order_relaxed);
+                counters->batch_occupancy_samples.fetch_add(1, std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < batch->count; ++i) {
+                checksum += batch->tuples[i].id ^ batch->tuples[i].timestamp;
+            }
+            DoNotOptimize(checksum);
 
-        std::vector<std::thread> threads;
-        threads.reserve(gen_thread_count);
-        std::mutex mutex;
-        for (size_t i = 0; i < gen_thread_count; ++i) {
-            threads.emplace_back(generator_func, &memory, memory_bytes, &tuple_sizes, &mutex);
+            (*lane_results)[lane].tuples_read += batch->count;
+            (*lane_results)[lane].bytes_read += batch->bytes;
+            lanes[lane]->empty.try_push(batch);
+            popped = true;
         }
-        for (auto& thread : threads) {
-            thread.join();
+        if (popped) {
+            counters->consumer_wait_cycles.fetch_add(spin.done(), std::memory_order_relaxed);
+        } else {
+            spin.wait();
         }
+    }
+}
 
-        const std::chrono::duration<double> elapsed_seconds =
-            std::chrono::high_resolution_clock::now() - timestamp;
-        fmt::print("Generated {} tuples ({} B) in {}s.\n", tuple_sizes.size(), memory.size(),
-                   elapsed_seconds.count());
-        // fmt::print("Memory contents:\n{}\n", (char*)(memory.data()));
-        // fmt::print("Tuple sizes: {}\n", fmt::join(tuple_sizes, ", "));
+// Creates the receivers of the parser threads for socket or file ingest.
+std::unique_ptr<IngestReceiver> make_receiver(const PlacedInput& input,
+                                              const BenchSettings& settings,
+                                              const SocketConnection* connection) {
+    if (settings.ingest_mode == IngestMode::socket) {
+        return make_socket_receiver(settings.receiver_kind, connection->receiver_fd(),
+                                    settings.ingest_buffer_size, MEMORY_PADDING);
     }
+    return make_file_reader(input.dataset_path, input.dataset_memory_offset, input.memory_size,
+                            settings.ingest_buffer_size, settings.io_depth, settings.direct_io,
+                            MEMORY_PADDING);
+}
 
-    /*
-     * Actual Benchmark
-     */
+// Streams the dataset file with one reader per parser thread for a second, without parsing, to see
+// what the storage delivers with the configured buffers and queue depth. Returns bytes per second.
+double measure_read_bandwidth(const PlacedInput& input,
+                              const std::vector<size_t>& thread_cpus,
+                              const BenchSettings& settings) {
+    std::vector<std::unique_ptr<IngestReceiver>> readers;
+    for (size_t i = 0; i < thread_cpus.size(); ++i) {
+        readers.push_back(make_receiver(input, settings, nullptr));
+    }
+    std::atomic<bool> stop_flag = false;
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < readers.size(); ++i) {
+        threads.emplace_back([&, i] {
+            if (!settings.pin_order.empty()) {
+                pin_current_thread_to_cpu(thread_cpus[i]);
+            }
+            readers[i]->run(stop_flag, [](std::span<const std::byte> /*data*/) {});
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    stop_flag.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    uint64_t bytes = 0;
+    for (const auto& reader : readers) {
+        bytes += reader->received_bytes.load();
+    }
+    return static_cast<double>(bytes) / elapsed.count();
+}
 
+// Runs the warmup and measurement of one parser with fresh threads and prints the results.
+RunResult run_benchmark(const std::string& parser_name,
+                        const BenchEntry& entry,
+                        const PlacedInput& input,
+                        size_t thread_count,
+                        const BenchSettings& settings) {
+    // A dataset mapped from a file keeps the batch size it was written with, whatever
+    // --record-batch says. The parser rejects invalid batches later on.
+    size_t batch_tuples = 0;
+    if (entry.record_batches) {
+        const DatasetView& dataset = input.node_views.front();
+        ColumnBatch first_batch;
+        if (parse_record_batch(dataset.memory.data(), dataset.memory.size(), &first_batch)) {
+            batch_tuples = first_batch.size();
+        }
+    }
+
+    RunResult run_result;
+    run_result.config = {
+        {"parser", parser_name},
+        {"format", std::string(entry.format)},
+        {"mode", settings.mode_name},
+        {"workload", settings.workload_name},
+        {"csv_dialect", settings.csv_dialect_name},
+        {"isa", settings.isa_name},
+        {"record_batch_tuples", uint64_t{batch_tuples}},
+        {"threads", uint64_t{thread_count}},
+        {"memory_bytes", uint64_t{input.memory_size}},
+        {"tuple_count", uint64_t{input.tuple_count}},
+        {"seed", input.seed},
+        {"sink", settings.sink_name},
+        {"batch_window", uint64_t{settings.parse_options.batch_window}},
+        {"framed", uint64_t{settings.parse_options.framed}},
+        {"pipeline_chunk", uint64_t{settings.pipeline_chunk_tuples}},
+        {"pipeline_depth",
+         uint64_t{settings.pipeline_chunk_tuples == 0 ? 0 : settings.pipeline_depth}},
+        {"ingest", settings.ingest_name},
+        {"compress", settings.compress_name},
+        {"compress_block",
+         uint64_t{settings.codec == Codec::none ? 0 : settings.compress_block_size}},
+        {"ingest_buffer",
+         uint64_t{settings.ingest_mode == IngestMode::memory ? 0 : settings.ingest_buffer_size}},
+        {"io_depth", uint64_t{settings.ingest_mode == IngestMode::file ? settings.io_depth : 0}},
+        {"numa", settings.numa_name},
+        {"pin", settings.pin_name},
+        {"latency_sample", uint64_t{settings.parse_options.latency_sample_interval}},
+        {"warmup_seconds", uint64_t{settings.warmup_seconds}},
+        {"measure_seconds", uint64_t{settings.measure_seconds}},
+    };
+
+    // Pinned threads use the input of the node their CPU belongs to, others are spread round robin.
+    std::vector<size_t> thread_cpus(thread_count);
+    std::vector<size_t> thread_nodes(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        thread_nodes[i] = i % input.numa_nodes;
+        if (!settings.pin_order.empty()) {
+            thread_cpus[i] = settings.pin_order[i % settings.pin_order.size()];
+            const size_t cpu_node = settings.topology.find(thread_cpus[i])->numa_node;
+            if (cpu_node < input.numa_nodes) {
+                thread_nodes[i] = cpu_node;
+            }
+        }
+    }
+    for (size_t node = 0; node < input.numa_nodes && settings.numa_mode == NumaMode::partition;
+         ++node) {
+        if (std::find(begin(thread_nodes), end(thread_nodes), node) == end(thread_nodes)) {
+            fmt::print(stderr,
+                       "Partitioning over {} nodes needs a parser thread per node, node {} has "
+                       "none.\n",
+                       input.numa_nodes, node);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+    }
+
+    const bool pipeline = settings.pipeline_chunk_tuples != 0;
     std::vector<std::thread> threads;
-    threads.reserve(thread_count);
+    threads.reserve(2 * thread_count + 2);
+    // In pipeline mode, the consumer counts the tuples of each lane here.
     std::vector<ThreadResult> thread_results(thread_count);
     std::atomic<bool> stop_flag = false;
 
+    std::vector<size_t> free_cpus;
+    if (!settings.pin_order.empty()) {
+        // Keep the reporting thread off the parser CPUs. Threads inherit the affinity of their
+        // creator, so this has to happen after the NUMA copies and each parser pins itself below.
+        for (const CpuInfo& info : settings.topology.cpus()) {
+            if (std::find(begin(thread_cpus), end(thread_cpus), info.cpu) == end(thread_cpus)) {
+                free_cpus.push_back(info.cpu);
+            }
+        }
+        if (!free_cpus.empty()) {
+            pin_current_thread_to_cpu(free_cpus.front());
+            fmt::print(stderr, "Pinned parser threads to CPUs {}, reporting thread to CPU {}.\n",
+                       fmt::join(thread_cpus, ","), free_cpus.front());
+        } else {
+            fmt::print(stderr, "\nWARNING\nNo free CPU for the reporting thread.\n\n");
+            fmt::print(stderr, "Pinned parser threads to CPUs {}.\n", fmt::join(thread_cpus, ","));
+        }
+    }
+
+    // Helper threads (pipeline stages, socket senders) run on the free CPUs after the reporting
+    // thread's, or anywhere if there are none.
+    const auto pin_helper_thread = [&](size_t index) {
+        if (free_cpus.size() > 1) {
+            pin_current_thread_to_cpu(free_cpus[1 + index % (free_cpus.size() - 1)]);
+        } else if (!settings.pin_order.empty()) {
+            unpin_current_thread();
+        }
+    };
+
+    // perf counters only count the thread that opened them, so every parser opens its own group.
+    std::vector<PerfCounterGroup> perf_groups(thread_count);
+    std::atomic<size_t> perf_groups_opened = 0;
+
+    std::vector<std::unique_ptr<PipelineLane>> lanes;
+    std::vector<std::vector<DatasetView>> node_chunks;
+    PipelineCounters pipeline_counters;
+    if (pipeline) {
+        for (size_t i = 0; i < thread_count; ++i) {
+            lanes.push_back(std::make_unique<PipelineLane>(settings.pipeline_depth,
+                                                           settings.pipeline_chunk_tuples));
+        }
+        for (const DatasetView& view : input.node_views) {
+            node_chunks.push_back(split_into_chunks(view, settings.pipeline_chunk_tuples));
+        }
+    }
+
+    // One connection / reader per parser thread, so a thread never waits for data of another one.
+    double read_bandwidth = 0;
+    std::vector<SocketConnection> connections;
+    std::vector<std::unique_ptr<IngestReceiver>> receivers;
+    if (settings.ingest_mode == IngestMode::file) {
+        read_bandwidth = measure_read_bandwidth(input, thread_cpus, settings);
+        fmt::print(stderr, "Reading {} without parsing: {:9.4g} GB/s.\n", input.dataset_path,
+                   read_bandwidth / 1e9);
+    }
+    if (settings.ingest_mode == IngestMode::socket) {
+        connections.resize(thread_count);
+    }
+    for (size_t i = 0; i < thread_count && settings.ingest_mode != IngestMode::memory; ++i) {
+        receivers.push_back(
+            make_receiver(input, settings, connections.empty() ? nullptr : &connections[i]));
+    }
+
+    uint64_t measure_tsc_start = tsc_begin();
+    uint64_t measure_tsc_stop = 0;
     auto timestamp = std::chrono::high_resolution_clock::now();
     for (size_t i = 0; i < thread_count; ++i) {
-        threads.emplace_back(parser_func, &thread_results[i], std::ref(memory),
-                             std::ref(tuple_sizes), std::ref(stop_flag));
+        threads.emplace_back([&, i] {
+            const size_t node = thread_nodes[i];
+            if (!settings.pin_order.empty()) {
+                pin_current_thread_to_cpu(thread_cpus[i]);
+            } else if (settings.numa_mode != NumaMode::off) {
+                bind_current_thread_to_numa_node(node);
+            }
+            if (settings.use_perf) {
+                perf_groups[i] = PerfCounterGroup::open_for_current_thread();
+                perf_groups_opened.fetch_add(1);
+            }
+            ParseOptions parse_options = settings.parse_options;
+            if (pipeline) {
+                parse_options.pipeline_lane = lanes[i].get();
+            }
+            if (!receivers.empty()) {
+                parse_options.receiver = receivers[i].get();
+            }
+            if (settings.codec != Codec::none) {
+                parse_options.compressed = &input.compressed;
+            }
+            switch (settings.mode) {
+                case BenchMode::parse:
+                    entry.parse(&thread_results[i], input.node_views[node], parse_options,
+                                stop_flag);
+                    break;
+                case BenchMode::serialize:
+                    entry.serialize(&thread_results[i], input.native_tuples, parse_options,
+                                    stop_flag);
+                    break;
+                case BenchMode::roundtrip:
+                    entry.roundtrip(&thread_results[i], input.native_tuples, parse_options,
+                                    stop_flag);
+                    break;
+            }
+        });
+    }
+    for (size_t i = 0; i < connections.size(); ++i) {
+        threads.emplace_back([&, i] {
+            pin_helper_thread(i);
+            run_socket_sender(connections[i].sender_fd(), input.node_views[thread_nodes[i]].memory);
+        });
+    }
+    if (pipeline) {
+        threads.emplace_back([&] {
+            pin_helper_thread(0);
+            run_pipeline_producer(node_chunks, thread_nodes, lanes, &pipeline_counters,
+                                  stop_flag);
+        });
+        threads.emplace_back([&] {
+            pin_helper_thread(1);
+            run_pipeline_consumer(lanes, &thread_results, &pipeline_counters, stop_flag);
+        });
+    }
+    while (settings.use_perf && perf_groups_opened.load() < thread_count) {
+        std::this_thread::yield();
     }
 
+    // The counters cover exactly the interval of the measurement samples, from the last exchange
+    // of the warmup to the last exchange of the measurement.
+    uint64_t perf_tsc_start = 0;
+    uint64_t perf_tsc_stop = 0;
+    const auto enable_perf = [&] {
+        for (const auto& group : perf_groups) {
+            group.enable();
+        }
+        perf_tsc_start = tsc_begin();
+    };
+    const auto disable_perf = [&] {
+        perf_tsc_stop = tsc_end();
+        for (const auto& group : perf_groups) {
+            group.disable();
+        }
+    };
+
+    if (pipeline) {
+        fmt::print(stderr,
+                   "Parsing {} with {} threads in a pipeline, chunks of {} tuples, queue depth "
+                   "{}.\n",
+                   parser_name, thread_count, settings.pipeline_chunk_tuples,
+                   lanes[0]->chunks.capacity());
+    } else if (settings.mode == BenchMode::serialize) {
+        fmt::print(stderr, "Serializing {} tuples with {} threads.\n", parser_name, thread_count);
+    } else {
+        fmt::print(stderr, "{} {} with {} threads into sink {}.\n",
+                   settings.mode == BenchMode::roundtrip ? "Serializing and parsing" : "Parsing",
+                   parser_name, thread_count, settings.sink_name);
+    }
     fmt::print(stderr, "Warmup...\n");
-    for (size_t iter = 0; iter < warmup_seconds; ++iter) {
+    for (size_t iter = 0; iter < settings.warmup_seconds; ++iter) {
         size_t tuples_sum = 0;
         size_t bytes_sum = 0;
         for (auto& result : thread_results) {
             tuples_sum += result.tuples_read.exchange(0);
             bytes_sum += result.bytes_read.exchange(0);
+            result.scan_cycles.exchange(0);
+            result.parse_cycles.exchange(0);
+            result.decompress_cycles.exchange(0);
+            result.fallback_tuples.exchange(0);
+        }
+        for (const auto& lane : lanes) {
+            lane->parser_wait_cycles.exchange(0);
+        }
+        pipeline_counters.producer_wait_cycles.exchange(0);
+        pipeline_counters.chunk_occupancy_sum.exchange(0);
+        pipeline_counters.chunk_occupancy_samples.exchange(0);
+        pipeline_counters.consumer_wait_cycles.exchange(0);
+        pipeline_counters.batch_occupancy_sum.exchange(0);
+        pipeline_counters.batch_occupancy_samples.exchange(0);
+        for (const auto& receiver : receivers) {
+            receiver->receive_cycles.exchange(0);
+            receiver->syscalls.exchange(0);
+        }
+        measure_tsc_start = tsc_begin();
+        if (settings.use_perf && iter + 1 == settings.warmup_seconds) {
+            enable_perf();
         }
         const auto end = std::chrono::high_resolution_clock::now();
         const std::chrono::duration<double> diff = end - timestamp;
@@ -204,15 +682,61 @@ int main(int argc, char** argv) {
     tuples_per_second_results.reserve(1000);
     std::vector<double> bytes_per_second_results;
     bytes_per_second_results.reserve(1000);
+    std::vector<std::vector<double>> node_tuples_per_second_results(input.numa_nodes);
+    std::vector<std::vector<double>> node_bytes_per_second_results(input.numa_nodes);
+
+    size_t measured_tuples = 0;
+    size_t measured_bytes = 0;
+    uint64_t measured_scan_cycles = 0;
+    uint64_t measured_parse_cycles = 0;
+    uint64_t measured_decompress_cycles = 0;
+    uint64_t measured_fallback_tuples = 0;
+    uint64_t measured_parser_wait_cycles = 0;
+    uint64_t measured_producer_wait_cycles = 0;
+    uint64_t measured_consumer_wait_cycles = 0;
+    std::array<uint64_t, 2> measured_chunk_occupancy{};  // sum, samples
+    std::array<uint64_t, 2> measured_batch_occupancy{};
+    uint64_t measured_receive_cycles = 0;
+    uint64_t measured_syscalls = 0;
+    if (settings.use_perf && settings.warmup_seconds == 0) {
+        enable_perf();
+    }
 
     fmt::print(stderr, "Measuring...\n");
-    for (size_t iter = 0; iter < measure_seconds; ++iter) {
-        size_t tuples_sum = 0;
-        size_t bytes_sum = 0;
-        for (auto& result : thread_results) {
-            tuples_sum += result.tuples_read.exchange(0);
-            bytes_sum += result.bytes_read.exchange(0);
+    for (size_t iter = 0; iter < settings.measure_seconds; ++iter) {
+        std::vector<size_t> node_tuples_sums(input.numa_nodes);
+        std::vector<size_t> node_bytes_sums(input.numa_nodes);
+        for (size_t i = 0; i < thread_count; ++i) {
+            node_tuples_sums[thread_nodes[i]] += thread_results[i].tuples_read.exchange(0);
+            node_bytes_sums[thread_nodes[i]] += thread_results[i].bytes_read.exchange(0);
+            measured_scan_cycles += thread_results[i].scan_cycles.exchange(0);
+            measured_parse_cycles += thread_results[i].parse_cycles.exchange(0);
+            measured_decompress_cycles += thread_results[i].decompress_cycles.exchange(0);
+            measured_fallback_tuples += thread_results[i].fallback_tuples.exchange(0);
+        }
+        for (const auto& lane : lanes) {
+            measured_parser_wait_cycles += lane->parser_wait_cycles.exchange(0);
+        }
+        measured_producer_wait_cycles += pipeline_counters.producer_wait_cycles.exchange(0);
+        measured_consumer_wait_cycles += pipeline_counters.consumer_wait_cycles.exchange(0);
+        measured_chunk_occupancy[0] += pipeline_counters.chunk_occupancy_sum.exchange(0);
+        measured_chunk_occupancy[1] += pipeline_counters.chunk_occupancy_samples.exchange(0);
+        measured_batch_occupancy[0] += pipeline_counters.batch_occupancy_sum.exchange(0);
+        measured_batch_occupancy[1] += pipeline_counters.batch_occupancy_samples.exchange(0);
+        for (const auto& receiver : receivers) {
+            measured_receive_cycles += receiver->receive_cycles.exchange(0);
+            measured_syscalls += receiver->syscalls.exchange(0);
         }
+        const size_t tuples_sum =
+            std::accumulate(begin(node_tuples_sums), end(node_tuples_sums), size_t{0});
+        const size_t bytes_sum =
+            std::accumulate(begin(node_bytes_sums), end(node_bytes_sums), size_t{0});
+        if (settings.use_perf && iter + 1 == settings.measure_seconds) {
+            disable_perf();
+        }
+        measure_tsc_stop = tsc_end();
+        measured_tuples += tuples_sum;
+        measured_bytes += bytes_sum;
         const auto end = std::chrono::high_resolution_clock::now();
         const std::chrono::duration<double> diff = end - timestamp;
         timestamp = end;
@@ -222,6 +746,12 @@ int main(int argc, char** argv) {
 
         tuples_per_second_results.push_back(tuples_per_second);
         bytes_per_second_results.push_back(bytes_per_second);
+        for (size_t node = 0; node < input.numa_nodes; ++node) {
+            node_tuples_per_second_results[node].push_back(
+                static_cast<double>(node_tuples_sums[node]) / diff.count());
+            node_bytes_per_second_results[node].push_back(
+                static_cast<double>(node_bytes_sums[node]) / diff.count());
+        }
 
         fmt::print(stderr, "{:11.6g} t/s.  {:11.6g} B/s = {:9.4g} GB/s\n", tuples_per_second,
                    bytes_per_second, bytes_per_second / 1e9);
@@ -247,7 +777,1068 @@ int main(int argc, char** argv) {
                bytes_mean, bytes_stddev, (bytes_stddev / bytes_mean * 100), bytes_error,
                (bytes_error / bytes_mean * 100));
 
+    if (settings.use_perf && measured_tuples != 0) {
+        const auto per_tuple = [&](uint64_t value) {
+            return static_cast<double>(value) / static_cast<double>(measured_tuples);
+        };
+        const auto per_byte = [&](uint64_t value) {
+            return static_cast<double>(value) / static_cast<double>(measured_bytes);
+        };
+
+        if (perf_groups[0].available()) {
+            PerfCounts counts = perf_groups[0].read();
+            for (size_t i = 1; i < thread_count; ++i) {
+                counts += perf_groups[i].read();
+            }
+
+            const auto& cycles = counts[PerfEvent::cycles];
+            const auto& instructions = counts[PerfEvent::instructions];
+            fmt::print(stderr, "perf counters of {} threads over {} tuples:", thread_count,
+                       measured_tuples);
+            if (cycles && instructions && *cycles != 0) {
+                const double ipc =
+                    static_cast<double>(*instructions) / static_cast<double>(*cycles);
+                fmt::print(stderr, " IPC {:.3f}", ipc);
+                run_result.metrics.emplace_back("perf_ipc", ipc);
+            }
+            fmt::print(stderr, "\n");
+            for (size_t event = 0; event < PERF_EVENT_COUNT; ++event) {
+                const auto& value = counts.values[event];
+                const std::string_view name = perf_event_name(static_cast<PerfEvent>(event));
+                if (value) {
+                    fmt::print(stderr, "  {:>13}: {:11.4f} per tuple  {:9.4f} per B\n", name,
+                               per_tuple(*value), per_byte(*value));
+                    run_result.metrics.emplace_back(fmt::format("perf_{}_per_tuple", name),
+                                                    per_tuple(*value));
+                    run_result.metrics.emplace_back(fmt::format("perf_{}_per_byte", name),
+                                                    per_byte(*value));
+                } else {
+                    fmt::print(stderr, "  {:>13}: not supported\n", name);
+                }
+            }
+        } else {
+            // Parser threads never block, so every thread spends all TSC ticks of the interval.
+            const uint64_t ticks = (perf_tsc_stop - perf_tsc_start) * thread_count;
+            fmt::print(stderr,
+                       "perf events unavailable (see kernel.perf_event_paranoid), TSC estimate: "
+                       "{:.4f} ticks per tuple  {:.4f} ticks per B\n",
+                       per_tuple(ticks), per_byte(ticks));
+            run_result.metrics.emplace_back("tsc_ticks_per_tuple", per_tuple(ticks));
+            run_result.metrics.emplace_back("tsc_ticks_per_byte", per_byte(ticks));
+        }
+    }
+
+    if (settings.parse_options.framed && measured_tuples != 0) {
+        const double tuples = static_cast<double>(measured_tuples);
+        const double scan_per_tuple = static_cast<double>(measured_scan_cycles) / tuples;
+        const double parse_per_tuple = static_cast<double>(measured_parse_cycles) / tuples;
+        const double scan_fraction = scan_per_tuple / (scan_per_tuple + parse_per_tuple);
+        fmt::print(stderr,
+                   "framing: boundary detection {:.2f}% of cycles, scan {:.2f} ticks per tuple, "
+                   "parse {:.2f} ticks per tuple\n",
+                   scan_fraction * 100, scan_per_tuple, parse_per_tuple);
+        run_result.metrics.emplace_back("framing_scan_ticks_per_tuple", scan_per_tuple);
+        run_result.metrics.emplace_back("framing_parse_ticks_per_tuple", parse_per_tuple);
+        run_result.metrics.emplace_back("framing_scan_fraction", scan_fraction);
+    }
+
+    if (settings.codec != Codec::none && measured_tuples != 0) {
+        // Parser threads decompress and parse alternately, the rest of their time is parsing.
+        const double thread_ticks = static_cast<double>(measure_tsc_stop - measure_tsc_start) *
+                                    static_cast<double>(thread_count);
+        const double decompress_fraction =
+            static_cast<double>(measured_decompress_cycles) / thread_ticks;
+        const double decompress_seconds =
+            static_cast<double>(measured_decompress_cycles) / estimate_tsc_ticks_per_ns() / 1e9;
+        const double decompress_bandwidth =
+            decompress_seconds == 0 ? 0.0
+                                    : static_cast<double>(measured_bytes) / decompress_seconds;
+        const double ratio = static_cast<double>(input.compressed.raw_size) /
+                             static_cast<double>(input.compressed.memory.size());
+        fmt::print(stderr,
+                   "compression: {} ratio {:.3f}, decompressing {:9.4g} GB/s per thread, {:.2f}% "
+                   "of parser thread time\n",
+                   settings.compress_name, ratio, decompress_bandwidth / 1e9,
+                   decompress_fraction * 100);
+        run_result.metrics.emplace_back("compress_ratio", ratio);
+        run_result.metrics.emplace_back("decompress_bytes_per_second", decompress_bandwidth);
+        run_result.metrics.emplace_back("decompress_fraction", decompress_fraction);
+    }
+
+    if (entry.record_batches && tuples_mean != 0) {
+        // Parser threads never block, so each one spends all of its time on its tuples.
+        const double ns_per_tuple = static_cast<double>(thread_count) * 1e9 / tuples_mean;
+        fmt::print(stderr, "record batches of {} tuples: {:.3f} ns per tuple and thread\n",
+                   batch_tuples, ns_per_tuple);
+        run_result.metrics.emplace_back("ns_per_tuple", ns_per_tuple);
+    }
+
+    // Pipeline runs count tuples at the consumer, which knows nothing about fallbacks.
+    if (entry.speculative && !pipeline && measured_tuples != 0) {
+        const double hit_rate = 1 - static_cast<double>(measured_fallback_tuples) /
+                                         static_cast<double>(measured_tuples);
+        fmt::print(stderr,
+                   "fast path: {:.2f}% of tuples, the rest fell back to the generic parser\n",
+                   hit_rate * 100);
+        run_result.metrics.emplace_back("fast_path_hit_rate", hit_rate);
+    }
+
+    if (pipeline && measured_tuples != 0) {
+        // Every stage polls instead of blocking, so it spends all TSC ticks of the interval either
+        // working or waiting.
+        const double stage_ticks = static_cast<double>(measure_tsc_stop - measure_tsc_start);
+        const double tuples = static_cast<double>(measured_tuples);
+        const double parser_wait = static_cast<double>(measured_parser_wait_cycles) /
+                                   (stage_ticks * static_cast<double>(thread_count));
+        const double producer_wait =
+            static_cast<double>(measured_producer_wait_cycles) / stage_ticks;
+        const double consumer_wait =
+            static_cast<double>(measured_consumer_wait_cycles) / stage_ticks;
+        const double parser_busy_per_tuple =
+            stage_ticks * static_cast<double>(thread_count) * (1 - parser_wait) / tuples;
+        const double consumer_busy_per_tuple = stage_ticks * (1 - consumer_wait) / tuples;
+        const auto average = [](const std::array<uint64_t, 2>& occupancy) {
+            return occupancy[1] == 0 ? 0.0
+                                     : static_cast<double>(occupancy[0]) /
+                                           static_cast<double>(occupancy[1]);
+        };
+        const double chunk_occupancy = average(measured_chunk_occupancy);
+        const double batch_occupancy = average(measured_batch_occupancy);
+        const size_t depth = lanes[0]->chunks.capacity();
+
+        fmt::print(stderr,
+                   "pipeline: waiting {:.2f}% producer, {:.2f}% parsers, {:.2f}% consumer. "
+                   "Average queue occupancy: chunks {:.2f}/{}, batches {:.2f}/{}\n",
+                   producer_wait * 100, parser_wait * 100, consumer_wait * 100, chunk_occupancy,
+                   depth, batch_occupancy, depth);
+        fmt::print(stderr,
+                   "pipeline: busy parser {:.2f} ticks per tuple incl. handoff, consumer {:.2f} "
+                   "ticks per tuple\n",
+                   parser_busy_per_tuple, consumer_busy_per_tuple);
+        run_result.metrics.emplace_back("pipeline_producer_wait_fraction", producer_wait);
+        run_result.metrics.emplace_back("pipeline_parser_wait_fraction", parser_wait);
+        run_result.metrics.emplace_back("pipeline_consumer_wait_fraction", consumer_wait);
+        run_result.metrics.emplace_back("pipeline_chunk_queue_occupancy", chunk_occupancy);
+        run_result.metrics.emplace_back("pipeline_batch_queue_occupancy", batch_occupancy);
+        run_result.metrics.emplace_back("pipeline_parser_busy_ticks_per_tuple",
+                                        parser_busy_per_tuple);
+        run_result.metrics.emplace_back("pipeline_consumer_busy_ticks_per_tuple",
+                                        consumer_busy_per_tuple);
+    }
+
+    if (settings.ingest_mode != IngestMode::memory && measured_tuples != 0) {
+        // Parser threads receive and parse alternately, the rest of their time is parsing.
+        const double thread_ticks = static_cast<double>(measure_tsc_stop - measure_tsc_start) *
+                                    static_cast<double>(thread_count);
+        const double receive_fraction = static_cast<double>(measured_receive_cycles) / thread_ticks;
+        const double syscalls = static_cast<double>(measured_syscalls);
+        const double bytes_per_syscall =
+            syscalls == 0 ? 0.0 : static_cast<double>(measured_bytes) / syscalls;
+        const double syscalls_per_tuple = syscalls / static_cast<double>(measured_tuples);
+        fmt::print(stderr,
+                   "ingest: receiving {:.2f}% of parser thread time, {:.0f} B per syscall, "
+                   "{:.4f} syscalls per tuple\n",
+                   receive_fraction * 100, bytes_per_syscall, syscalls_per_tuple);
+        run_result.metrics.emplace_back("ingest_receive_fraction", receive_fraction);
+        run_result.metrics.emplace_back("ingest_bytes_per_syscall", bytes_per_syscall);
+        run_result.metrics.emplace_back("ingest_syscalls_per_tuple", syscalls_per_tuple);
+        if (settings.ingest_mode == IngestMode::file && read_bandwidth != 0) {
+            // Parsing keeping up with (almost) everything the storage delivers means more CPU
+            // would not help.
+            const double used_fraction = bytes_mean / read_bandwidth;
+            fmt::print(stderr,
+                       "ingest: parsing {:9.4g} GB/s of {:9.4g} GB/s read bandwidth ({:.1f}%), "
+                       "{}-bound\n",
+                       bytes_mean / 1e9, read_bandwidth / 1e9, used_fraction * 100,
+                       used_fraction >= 0.9 ? "I/O" : "CPU");
+            run_result.metrics.emplace_back("ingest_read_bandwidth", read_bandwidth);
+            run_result.metrics.emplace_back("ingest_read_bandwidth_used", used_fraction);
+        }
+    }
+
+    if (settings.numa_mode != NumaMode::off) {
+        for (size_t node = 0; node < input.numa_nodes; ++node) {
+            auto [node_tuples_mean, node_tuples_stddev, node_tuples_error] =
+                mean_stddev_99error_from_samples(node_tuples_per_second_results[node]);
+            auto [node_bytes_mean, node_bytes_stddev, node_bytes_error] =
+                mean_stddev_99error_from_samples(node_bytes_per_second_results[node]);
+            fmt::print(stderr,
+                       "node {}: mean: {:11.6g} t/s (99% error {:6.3f}%).   {:9.4g} GB/s (99% "
+                       "error {:6.3f}%)\n",
+                       node, node_tuples_mean, (node_tuples_error / node_tuples_mean * 100),
+                       node_bytes_mean / 1e9, (node_bytes_error / node_bytes_mean * 100));
+        }
+    }
+
     for (auto& thread : threads) {
         thread.join();
     }
+
+    if (settings.parse_options.latency_sample_interval != 0) {
+        LatencyHistogram latency;
+        for (const auto& result : thread_results) {
+            latency.merge(result.latency);
+        }
+        if (latency.count() == 0) {
+            fmt::print(stderr, "latency: no samples, {} is a batched parser.\n",
+                       parser_name);
+        } else {
+            const double ticks_per_ns = estimate_tsc_ticks_per_ns();
+            const auto print_quantile = [&](std::string_view name, uint64_t ticks) {
+                const double ns = static_cast<double>(ticks) / ticks_per_ns;
+                fmt::print(stderr, "  {:>5}: {:9} cycles = {:9.1f} ns\n", name, ticks, ns);
+                run_result.metrics.emplace_back(fmt::format("latency_{}_cycles", name),
+                                                static_cast<double>(ticks));
+                run_result.metrics.emplace_back(fmt::format("latency_{}_ns", name), ns);
+            };
+            fmt::print(stderr,
+                       "latency of {} ({} samples incl. ~{} cycles timer overhead, TSC at {:.3f} "
+                       "GHz):\n",
+                       parser_name, latency.count(),
+                       estimate_tsc_overhead(), ticks_per_ns);
+            print_quantile("p50", latency.value_at_quantile(0.5));
+            print_quantile("p99", latency.value_at_quantile(0.99));
+            print_quantile("p99.9", latency.value_at_quantile(0.999));
+            print_quantile("max", latency.max());
+        }
+    }
+
+    run_result.tuples_per_second = std::move(tuples_per_second_results);
+    run_result.bytes_per_second = std::move(bytes_per_second_results);
+    return run_result;
+}
+
+// Throughput per thread count of one parser, relative to the smallest thread count of the sweep.
+void report_scaling(const std::string& parser_name,
+                    const std::vector<size_t>& thread_counts,
+                    std::span<RunResult> runs,
+                    double efficiency_threshold) {
+    std::vector<double> means;
+    for (const RunResult& run : runs) {
+        means.push_back(std::get<0>(mean_stddev_99error_from_samples(run.tuples_per_second)));
+    }
+    const size_t reference =
+        static_cast<size_t>(std::min_element(begin(thread_counts), end(thread_counts)) -
+                            begin(thread_counts));
+    const double reference_per_thread =
+        means[reference] / static_cast<double>(thread_counts[reference]);
+
+    fmt::print(stderr, "\nScaling of {} (efficiency relative to {} thread(s)):\n", parser_name,
+               thread_counts[reference]);
+    fmt::print(stderr, "{:>8} {:>12} {:>14} {:>11}\n", "threads", "t/s", "t/s per thread",
+               "efficiency");
+    bool knee_found = false;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const double per_thread = means[i] / static_cast<double>(thread_counts[i]);
+        const double efficiency = per_thread / reference_per_thread;
+        runs[i].metrics.emplace_back("tuples_per_second_per_thread", per_thread);
+        runs[i].metrics.emplace_back("parallel_efficiency", efficiency);
+
+        // the knee is the first thread count that falls below the threshold
+        const bool knee = !knee_found && efficiency < efficiency_threshold;
+        knee_found = knee_found || knee;
+        fmt::print(stderr, "{:>8} {:>12.6g} {:>14.6g} {:>10.1f}%{}\n", thread_counts[i],
+                   means[i], per_thread, efficiency * 100,
+                   knee ? fmt::format("  <- knee, below {:.0f}%", efficiency_threshold * 100)
+                        : "");
+    }
+}
+
+int main(int argc, char** argv) {
+    /*
+     * Command Line Arguments
+     */
+
+    cxxopts::Options options("Parser Benchmark",
+                             "Benchmark parsing performance of different data formats and parsers");
+    // clang-format off
+    options.add_options()
+        ("m,memory", "How much memory to use for input tuples. Supported suffixed: k, m, g, t", cxxopts::value<std::string>())
+        ("seed", "Seed for the tuple generator. The same seed always generates the same tuples. Default: random", cxxopts::value<uint64_t>())
+        ("dataset-out", "Write the generated tuples to this dataset file", cxxopts::value<std::string>())
+        ("workload", "Value distributions of the generated tuples: uniform (64-bit ids and timestamps, loads in [0, 1), fixed floats), telemetry (ids below 10000, monotonic millisecond timestamps with jitter, CPU percent and load averages, 2dp floats) or sequential (like telemetry, but ids count up and shortest floats)", cxxopts::value<std::string>()->default_value("uniform"))
+        ("float-format", "How csv and json print floats: fixed (6 decimals), shortest (shortest round trip) or 2dp (two decimals). Default: the one of --workload", cxxopts::value<std::string>())
+        ("dataset-in", "Map tuples from this dataset file instead of generating them. Use a file on /dev/shm to share one copy between bench processes", cxxopts::value<std::string>())
+        ("t,threads", "How many threads to use for parsing tuples.", cxxopts::value<size_t>())
+        ("threads-sweep", "Run every parser with each of these thread counts instead of -t, e.g. 1,2,4,max. max is the number of CPUs (pinned CPUs with --pin)", cxxopts::value<std::string>())
+        ("efficiency-threshold", "Parallel efficiency below which --threads-sweep marks the knee of the scaling curve", cxxopts::value<double>()->default_value("0.8"))
+        ("p,parser", "Parsers to use, comma separated, or all. Parsers of the same format run one after another on the same input", cxxopts::value<std::string>())
+        ("mode", "What to measure: parse (the serialized input), serialize (encoding the input tuples into a reused buffer per thread, once per serializer of a format) or roundtrip (serializing runs of tuples and parsing them back)", cxxopts::value<std::string>()->default_value("parse"))
+        ("w,warmup", "Seconds to wait for warmup", cxxopts::value<size_t>()->default_value("10"))
+        ("i,iterations", "Seconds to measure", cxxopts::value<size_t>()->default_value("30"))
+        ("sink", "Where parsed tuples are written: discard, aos (array of tuples), soa (one array per column)", cxxopts::value<std::string>()->default_value("discard"))
+        ("latency-sample", "Time every n-th tuple of tuple-at-a-time parsers and report latency percentiles. 0 disables sampling", cxxopts::value<size_t>()->default_value("0"))
+        ("isa", "Instruction set of the dispatched parsing kernels (hex strings, csvsimd, svb): auto (the best the CPU supports), scalar, sse4.2, avx2 or avx512. simdjson parsers always use the implementation built in with -march", cxxopts::value<std::string>()->default_value("auto"))
+        ("perf", "Count cycles, instructions, cache, branch and dTLB misses of the parser threads during the measurement")
+        ("pin", "Pinning of generator and parser threads: none, compact (fill SMT siblings first), scatter (spread over packages and cores), cores (one thread per physical core), or a CPU list like 0,2,4-7", cxxopts::value<std::string>()->default_value("none"))
+        ("numa", "NUMA placement of the input: off, replicate (one copy per node), partition (each node gets a contiguous part of the tuples). Parser threads are bound to the node holding their input", cxxopts::value<std::string>()->default_value("off"))
+        ("framing", "Store csv and json tuples as one newline-delimited stream: parsers have to find the record boundaries instead of using precomputed tuple sizes")
+        ("pipeline", "Stream the input through a producer thread, the parser threads and a consumer thread connected by lock-free queues, handing chunks of this many tuples to the parsers. Throughput is counted at the consumer. 0 disables", cxxopts::value<size_t>()->default_value("0"))
+        ("pipeline-depth", "Chunks and tuple batches every pipeline queue holds, rounded up to a power of two", cxxopts::value<size_t>()->default_value("16"))
+        ("ingest", "Where parser threads get their input: memory, socket (streamed by a sender thread per parser over an AF_UNIX stream socket), or file (read from the file of --dataset-in / --dataset-out with io_uring, needs liburing)", cxxopts::value<std::string>()->default_value("memory"))
+        ("receiver", "How socket ingest receives: epoll (recv into a reusable buffer) or uring (io_uring multishot recv into provided buffers, needs liburing)", cxxopts::value<std::string>()->default_value("epoll"))
+        ("ingest-buffer", "Bytes per receive buffer / file read for --ingest", cxxopts::value<size_t>()->default_value("65536"))
+        ("io-depth", "Buffers per parser thread for --ingest file: while one is parsed, the others are being read", cxxopts::value<size_t>()->default_value("3"))
+        ("direct-io", "Open the file of --ingest file with O_DIRECT, bypassing the page cache")
+        ("csv-delimiter", "Field delimiter of the csv-lines format of csvsimd: a single character or tab. Without this and --csv-quoting, a --dataset-in file brings its own dialect", cxxopts::value<std::string>()->default_value(","))
+        ("csv-quoting", "Quoted fields in the csv-lines format of csvsimd: none, text (the container id) or all", cxxopts::value<std::string>()->default_value("none"))
+        ("compress", "Compress the input in blocks of whole tuples, which parser threads decompress into a buffer of their own before parsing: none, lz4 or zstd", cxxopts::value<std::string>()->default_value("none"))
+        ("compress-block", "Bytes of tuples per compressed block, a larger tuple gets a block of its own", cxxopts::value<size_t>()->default_value("65536"))
+        ("compress-level", "Compression level: 0 for the default of the codec, lz4 uses LZ4 HC above 0", cxxopts::value<int>()->default_value("0"))
+        ("record-batch", "Tuples per generated record batch of the columnar format. Vary it to see the per-tuple cost as a function of the batch size", cxxopts::value<size_t>()->default_value("1024"))
+        ("batch-window", "Bytes per stage-1 pass for batched parsers (simdjsonmany). Must be larger than the largest tuple.", cxxopts::value<size_t>()->default_value("1000000"))
+        ("output", "Also write the results as json or csv", cxxopts::value<std::string>())
+        ("output-file", "File for --output, - for stdout. Informational output always goes to stderr", cxxopts::value<std::string>()->default_value("-"))
+        ("compare", "Compare two json result files: --compare baseline.json,candidate.json. Flags throughput changes whose 99% confidence intervals do not overlap and exits with 1 on a regression", cxxopts::value<std::vector<std::string>>())
+        ("h,help", "Print usage");
+    // clang-format on
+
+    const auto arguments = options.parse(argc, argv);
+
+    if (arguments.count("help") != 0) {
+        fmt::print("{}\n", options.help());
+        exit(0);  // NOLINT(concurrency-mt-unsafe)
+    }
+
+    if (arguments.count("compare") != 0) {
+        const auto files = arguments["compare"].as<std::vector<std::string>>();
+        if (files.size() != 2) {
+            fmt::print(stderr, "--compare needs exactly two result files.\n");
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        try {
+            const size_t regressions = compare_results(files[0], files[1]);
+            exit(regressions == 0 ? 0 : 1);  // NOLINT(concurrency-mt-unsafe)
+        } catch (const std::runtime_error& e) {
+            fmt::print(stderr, "{}\n", e.what());
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+    }
+
+    std::optional<std::string> output_format;
+    if (arguments.count("output") != 0) {
+        output_format = arguments["output"].as<std::string>();
+        if (output_format != "json" && output_format != "csv") {
+            fmt::print(stderr, "Invalid argument for output: {}.\n", *output_format);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+    }
+
+    uint64_t memory_bytes = 0;
+    if (arguments.count("dataset-in") == 0) {
+        size_t suffix_position{};
+        const auto memory_bytes_string = arguments["memory"].as<std::string>();
+        memory_bytes = std::stoll(memory_bytes_string, &suffix_position, 0);
+        if (suffix_position == memory_bytes_string.length() - 1) {
+            const char suffix = static_cast<char>(
+                std::tolower(static_cast<unsigned char>(memory_bytes_string.at(suffix_position))));
+            const std::map multiplicators{
+                std::make_pair('k', 1000ULL),
+                std::make_pair('m', 1000ULL * 1000),
+                std::make_pair('g', 1000ULL * 1000 * 1000),
+                std::make_pair('t', 1000ULL * 1000 * 1000 * 1000),
+            };
+            const auto it = multiplicators.find(suffix);
+            if (it == multiplicators.end()) {
+                fmt::print(stderr, "Invalid argument for memory: {}.\n", memory_bytes_string);
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+            memory_bytes *= it->second;
+        } else if (suffix_position < memory_bytes_string.length() - 1) {
+            fmt::print(stderr, "Invalid argument for memory: {}.\nAllowed suffixes: k, m, g, t.",
+                       memory_bytes_string);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+    }
+
+    BenchSettings settings{};
+    settings.mode_name = arguments["mode"].as<std::string>();
+    settings.warmup_seconds = arguments["warmup"].as<size_t>();
+    settings.measure_seconds = arguments["iterations"].as<size_t>();
+    settings.use_perf = arguments.count("perf") != 0;
+    settings.sink_name = arguments["sink"].as<std::string>();
+    settings.numa_name = arguments["numa"].as<std::string>();
+    settings.pin_name = arguments["pin"].as<std::string>();
+    settings.pipeline_chunk_tuples = arguments["pipeline"].as<size_t>();
+    settings.pipeline_depth = arguments["pipeline-depth"].as<size_t>();
+    settings.ingest_buffer_size = arguments["ingest-buffer"].as<size_t>();
+    settings.io_depth = arguments["io-depth"].as<size_t>();
+    settings.direct_io = arguments.count("direct-io") != 0;
+
+    // clang-format off
+    const std::map workload_profiles{
+        std::make_pair("uniform"s, WorkloadProfile{IdDistribution::uniform, TimestampDistribution::uniform, LoadDistribution::unit, FloatFormat::fixed}),
+        std::make_pair("telemetry"s, WorkloadProfile{IdDistribution::small, TimestampDistribution::monotonic, LoadDistribution::realistic, FloatFormat::two_decimals}),
+        std::make_pair("sequential"s, WorkloadProfile{IdDistribution::sequential, TimestampDistribution::monotonic, LoadDistribution::realistic, FloatFormat::shortest}),
+    };
+    // clang-format on
+    const std::map float_formats{
+        std::make_pair("fixed"s, FloatFormat::fixed),
+        std::make_pair("shortest"s, FloatFormat::shortest),
+        std::make_pair("2dp"s, FloatFormat::two_decimals),
+    };
+    // Selects profile/float format, or the profile's own float format if float_format is empty.
+    const auto select_workload = [&](const std::string& profile, const std::string& float_format) {
+        const auto profile_it = workload_profiles.find(profile);
+        if (profile_it == workload_profiles.end()) {
+            fmt::print(stderr, "Invalid argument for workload: {}.\n", profile);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        settings.workload = profile_it->second;
+        if (!float_format.empty()) {
+            const auto float_it = float_formats.find(float_format);
+            if (float_it == float_formats.end()) {
+                fmt::print(stderr, "Invalid argument for float-format: {}.\n", float_format);
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+            settings.workload.floats = float_it->second;
+        }
+        const auto name_it =
+            std::find_if(begin(float_formats), end(float_formats),
+                         [&](const auto& item) { return item.second == settings.workload.floats; });
+        settings.workload_name = fmt::format("{}/{}", profile, name_it->first);
+        text_float_format = settings.workload.floats;
+    };
+    const bool workload_given =
+        arguments.count("workload") != 0 || arguments.count("float-format") != 0;
+    select_workload(arguments["workload"].as<std::string>(),
+                    arguments.count("float-format") != 0
+                        ? arguments["float-format"].as<std::string>()
+                        : std::string());
+
+    // A dataset file may bring its own dialect, unless one is given.
+    const bool csv_dialect_given =
+        arguments.count("csv-delimiter") != 0 || arguments.count("csv-quoting") != 0;
+    {
+        const auto delimiter_name = arguments["csv-delimiter"].as<std::string>();
+        const auto quoting_name = arguments["csv-quoting"].as<std::string>();
+        const auto dialect = parse_csv_dialect(delimiter_name, quoting_name);
+        if (!dialect) {
+            fmt::print(stderr, "Invalid argument for csv-delimiter or csv-quoting: {}, {}.\n",
+                       delimiter_name, quoting_name);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        settings.parse_options.csv_dialect = *dialect;
+        settings.csv_dialect_name = csv_dialect_name(*dialect);
+    }
+
+    {
+        const std::map isas{
+            std::make_pair("scalar"s, Isa::scalar),
+            std::make_pair("sse4.2"s, Isa::sse42),
+            std::make_pair("avx2"s, Isa::avx2),
+            std::make_pair("avx512"s, Isa::avx512),
+        };
+        const auto isa_arg = arguments["isa"].as<std::string>();
+        if (isa_arg != "auto") {
+            const auto isa_it = isas.find(isa_arg);
+            if (isa_it == isas.end()) {
+                fmt::print(stderr, "Invalid argument for isa: {}.\n", isa_arg);
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+            try {
+                select_kernels(isa_it->second);
+            } catch (const std::runtime_error& e) {
+                fmt::print(stderr, "Invalid argument for isa: {}.\n", e.what());
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+        }
+        settings.isa_name = std::string(isa_name(kernels.isa));
+    }
+
+    {
+        // The header stores the count in 32 bits.
+        const auto batch_tuples = arguments["record-batch"].as<size_t>();
+        if (batch_tuples == 0 || batch_tuples > UINT32_MAX) {
+            fmt::print(stderr, "Invalid argument for record-batch: {}.\n", batch_tuples);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        settings.record_batch_tuples = batch_tuples;
+    }
+
+    ParseOptions& parse_options = settings.parse_options;
+    parse_options.batch_window = arguments["batch-window"].as<size_t>();
+    parse_options.latency_sample_interval = arguments["latency-sample"].as<size_t>();
+    parse_options.framed = arguments.count("framing") != 0;
+    if (settings.pipeline_chunk_tuples != 0 &&
+        (parse_options.framed || parse_options.latency_sample_interval != 0)) {
+        fmt::print(stderr, "--pipeline cannot be combined with --framing or --latency-sample.\n");
+        exit(1);  // NOLINT(concurrency-mt-unsafe)
+    }
+    // Framed parsing finds the tuple boundaries itself and does not time single tuples.
+    if (parse_options.framed && parse_options.latency_sample_interval != 0) {
+        fmt::print(stderr, "--framing cannot be combined with --latency-sample.\n");
+        exit(1);  // NOLINT(concurrency-mt-unsafe)
+    }
+    {
+        const std::map modes{
+            std::make_pair("parse"s, BenchMode::parse),
+            std::make_pair("serialize"s, BenchMode::serialize),
+            std::make_pair("roundtrip"s, BenchMode::roundtrip),
+        };
+        const auto mode_it = modes.find(settings.mode_name);
+        if (mode_it == modes.end()) {
+            fmt::print(stderr, "Invalid argument for mode: {}.\n", settings.mode_name);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        settings.mode = mode_it->second;
+    }
+    {
+        const std::map sinks{
+            std::make_pair("discard"s, OutputSink::discard),
+            std::make_pair("aos"s, OutputSink::aos),
+            std::make_pair("soa"s, OutputSink::soa),
+        };
+        const auto sink_it = sinks.find(arguments["sink"].as<std::string>());
+        if (sink_it == sinks.end()) {
+            fmt::print(stderr, "Invalid argument for sink: {}.\n",
+                       arguments["sink"].as<std::string>());
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        parse_options.sink = sink_it->second;
+    }
+
+    {
+        const std::map ingest_modes{
+            std::make_pair("memory"s, IngestMode::memory),
+            std::make_pair("socket"s, IngestMode::socket),
+            std::make_pair("file"s, IngestMode::file),
+        };
+        const auto ingest_it = ingest_modes.find(arguments["ingest"].as<std::string>());
+        if (ingest_it == ingest_modes.end()) {
+            fmt::print(stderr, "Invalid argument for ingest: {}.\n",
+                       arguments["ingest"].as<std::string>());
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        settings.ingest_mode = ingest_it->second;
+
+        const std::map receivers{
+            std::make_pair("epoll"s, ReceiverKind::epoll),
+            std::make_pair("uring"s, ReceiverKind::uring),
+        };
+        const auto receiver_it = receivers.find(arguments["receiver"].as<std::string>());
+        if (receiver_it == receivers.end()) {
+            fmt::print(stderr, "Invalid argument for receiver: {}.\n",
+                       arguments["receiver"].as<std::string>());
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        settings.receiver_kind = receiver_it->second;
+
+        switch (settings.ingest_mode) {
+            case IngestMode::memory:
+                settings.ingest_name = "memory";
+                break;
+            case IngestMode::socket:
+                settings.ingest_name = fmt::format("socket-{}", receiver_it->first);
+                break;
+            case IngestMode::file:
+                settings.ingest_name = settings.direct_io ? "file-direct" : "file";
+                break;
+        }
+        if ((settings.ingest_mode == IngestMode::file ||
+             (settings.ingest_mode == IngestMode::socket &&
+              settings.receiver_kind == ReceiverKind::uring)) &&
+            !uring_supported()) {
+            fmt::print(stderr, "--ingest {} needs a build with liburing.\n", settings.ingest_name);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        if (settings.ingest_mode == IngestMode::file && arguments.count("dataset-in") == 0 &&
+            arguments.count("dataset-out") == 0) {
+            fmt::print(stderr, "--ingest file reads the file of --dataset-in or --dataset-out.\n");
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        if (settings.ingest_mode == IngestMode::file && settings.io_depth == 0) {
+            fmt::print(stderr, "--io-depth must be at least 1.\n");
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        if (settings.ingest_mode != IngestMode::memory &&
+            (settings.pipeline_chunk_tuples != 0 || parse_options.framed ||
+             parse_options.latency_sample_interval != 0 || settings.ingest_buffer_size == 0)) {
+            fmt::print(stderr,
+                       "--ingest needs a non-zero --ingest-buffer and cannot be combined with "
+                       "--pipeline, --framing or --latency-sample.\n");
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+    }
+
+    {
+        const std::map numa_modes{
+            std::make_pair("off"s, NumaMode::off),
+            std::make_pair("replicate"s, NumaMode::replicate),
+            std::make_pair("partition"s, NumaMode::partition),
+        };
+        const auto numa_it = numa_modes.find(arguments["numa"].as<std::string>());
+        if (numa_it == numa_modes.end()) {
+            fmt::print(stderr, "Invalid argument for numa: {}.\n",
+                       arguments["numa"].as<std::string>());
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        settings.numa_mode = numa_it->second;
+    }
+    if (settings.ingest_mode == IngestMode::file && settings.numa_mode != NumaMode::off) {
+        fmt::print(stderr, "--ingest file cannot be combined with --numa.\n");
+        exit(1);  // NOLINT(concurrency-mt-unsafe)
+    }
+    {
+        const std::map codecs{
+            std::make_pair("none"s, Codec::none),
+            std::make_pair("lz4"s, Codec::lz4),
+            std::make_pair("zstd"s, Codec::zstd),
+        };
+        const auto codec_it = codecs.find(arguments["compress"].as<std::string>());
+        if (codec_it == codecs.end()) {
+            fmt::print(stderr, "Invalid argument for compress: {}.\n",
+                       arguments["compress"].as<std::string>());
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        settings.codec = codec_it->second;
+        settings.compress_block_size = arguments["compress-block"].as<size_t>();
+        settings.compress_level = arguments["compress-level"].as<int>();
+        settings.compress_name =
+            settings.codec == Codec::none || settings.compress_level == 0
+                ? codec_it->first
+                : fmt::format("{}-{}", codec_it->first, settings.compress_level);
+    }
+    if (settings.codec != Codec::none &&
+        (settings.compress_block_size == 0 || settings.mode != BenchMode::parse ||
+         settings.pipeline_chunk_tuples != 0 || parse_options.framed ||
+         parse_options.latency_sample_interval != 0 || settings.ingest_mode != IngestMode::memory ||
+         settings.numa_mode != NumaMode::off)) {
+        fmt::print(stderr,
+                   "--compress needs a non-zero --compress-block and --mode parse, and cannot be "
+                   "combined with --pipeline, --framing, --latency-sample, --ingest or --numa.\n");
+        exit(1);  // NOLINT(concurrency-mt-unsafe)
+    }
+    if (settings.mode != BenchMode::parse &&
+        (settings.pipeline_chunk_tuples != 0 || parse_options.framed ||
+         parse_options.latency_sample_interval != 0 || settings.ingest_mode != IngestMode::memory ||
+         settings.numa_mode != NumaMode::off)) {
+        fmt::print(stderr,
+                   "--mode {} cannot be combined with --pipeline, --framing, --latency-sample, "
+                   "--ingest or --numa.\n",
+                   settings.mode_name);
+        exit(1);  // NOLINT(concurrency-mt-unsafe)
+    }
+
+    settings.topology = CpuTopology::detect();
+    const CpuTopology& topology = settings.topology;
+    fmt::print(stderr, "CPU topology: {} packages, {} cores, {} CPUs ({}-way SMT), {} LLCs: {}.\n",
+               topology.package_count(), topology.core_count(), topology.cpus().size(),
+               topology.smt_width(), topology.llc_count(),
+               fmt::join(topology.llc_cpu_lists(), " | "));
+
+    const std::string& pin_policy = settings.pin_name;
+    std::vector<size_t>& pin_order = settings.pin_order;
+    if (pin_policy != "none") {
+        try {
+            pin_order = cpu_order_for_policy(topology, pin_policy);
+        } catch (const std::runtime_error& e) {
+            fmt::print(stderr, "Invalid argument for pin: {}.\n", e.what());
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        if (pin_order.empty()) {
+            fmt::print(stderr, "Pin policy {} selects no CPUs.\n", pin_policy);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+    }
+
+    std::vector<size_t> thread_counts;
+    if (arguments.count("threads-sweep") != 0) {
+        const size_t max_threads = pin_order.empty()
+                                       ? std::max(1U, std::thread::hardware_concurrency())
+                                       : pin_order.size();
+        for (const auto& item : split_comma_list(arguments["threads-sweep"].as<std::string>())) {
+            size_t count = 0;
+            const char* const item_end = item.data() + item.size();
+            const auto [parsed_end, error] = std::from_chars(item.data(), item_end, count);
+            if (item == "max") {
+                count = max_threads;
+            } else if (error != std::errc() || parsed_end != item_end || count == 0) {
+                fmt::print(stderr, "Invalid argument for threads-sweep: {}.\n", item);
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+            thread_counts.push_back(count);
+        }
+    } else {
+        thread_counts.push_back(arguments["threads"].as<size_t>());
+    }
+
+    // clang-format off
+    const std::map generator_parser_map{
+        std::make_pair("native"s, BenchEntry{"native", generate_tuples<serialize_native>, parse_tuples<parse_native>, serialize_tuples<serialize_native>, roundtrip_tuples<serialize_native, parse_native>}),
+
+        std::make_pair("rapidjson"s, BenchEntry{"json", generate_tuples<serialize_json>, parse_tuples<parse_rapidjson>, serialize_tuples<serialize_json>, roundtrip_tuples<serialize_json, parse_rapidjson>}),
+        std::make_pair("rapidjsoninsitu"s, BenchEntry{"json", generate_tuples<serialize_json>, parse_tuples<parse_rapidjson_insitu>, serialize_tuples<serialize_json>, roundtrip_tuples<serialize_json, parse_rapidjson_insitu>}),
+        std::make_pair("rapidjsonsax"s, BenchEntry{"json", generate_tuples<serialize_json>, parse_tuples<parse_rapidjson_sax>, serialize_tuples<serialize_json>, roundtrip_tuples<serialize_json, parse_rapidjson_sax>}),
+
+        std::make_pair("simdjson"s, BenchEntry{"json", generate_tuples<serialize_json>, parse_tuples<parse_simdjson>, serialize_tuples<serialize_json>, roundtrip_tuples<serialize_json, parse_simdjson>}),
+        std::make_pair("simdjsonec"s, BenchEntry{"json", generate_tuples<serialize_json>, parse_tuples<parse_simdjson_error_codes>, serialize_tuples<serialize_json>, roundtrip_tuples<serialize_json, parse_simdjson_error_codes>}),
+        std::make_pair("simdjsonece"s, BenchEntry{"json", generate_tuples<serialize_json>, parse_tuples<parse_simdjson_error_codes_early>, serialize_tuples<serialize_json>, roundtrip_tuples<serialize_json, parse_simdjson_error_codes_early>}),
+        std::make_pair("simdjsonu"s, BenchEntry{"json", generate_tuples<serialize_json>, parse_tuples<parse_simdjson_unescaped>, serialize_tuples<serialize_json>, roundtrip_tuples<serialize_json, parse_simdjson_unescaped>}),
+        std::make_pair("jsonfastpath"s, BenchEntry{"json", generate_tuples<serialize_json>, parse_tuples<parse_json_fast_path>, serialize_tuples<serialize_json>, roundtrip_tuples<serialize_json, parse_json_fast_path>, false, false, true}),
+        std::make_pair("simdjsonooo"s, BenchEntry{"json", generate_tuples<serialize_json>, parse_tuples<parse_simdjson_out_of_order>, serialize_tuples<serialize_json>, roundtrip_tuples<serialize_json, parse_simdjson_out_of_order>}),
+        std::make_pair("simdjsonmany"s, BenchEntry{"ndjson", generate_tuples<serialize_ndjson>, parse_tuple_batches<parse_simdjson_many>, serialize_tuples<serialize_ndjson>, roundtrip_tuple_batches<serialize_ndjson, parse_simdjson_many>, true}),
+
+        std::make_pair("flatbuf"s, BenchEntry{"flatbuf", generate_tuples<serialize_flatbuffer>, parse_tuples<parse_flatbuffer>, serialize_tuples<serialize_flatbuffer>, roundtrip_tuples<serialize_flatbuffer, parse_flatbuffer>}),
+        std::make_pair("protobuf"s, BenchEntry{"protobuf", generate_tuples<serialize_protobuf>, parse_tuples<parse_protobuf>, serialize_tuples<serialize_protobuf>, roundtrip_tuples<serialize_protobuf, parse_protobuf>}),
+        std::make_pair("avro"s, BenchEntry{"avro", generate_tuples<serialize_avro>, parse_tuples<parse_avro>, serialize_tuples<serialize_avro>, roundtrip_tuples<serialize_avro, parse_avro>}),
+        std::make_pair("columnar"s, BenchEntry{"columnar", generate_record_batches, parse_record_batches, nullptr, nullptr, false, false, false, true}),
+        std::make_pair("svb"s, BenchEntry{"svb", generate_tuples<serialize_svb>, parse_tuples<parse_svb>, serialize_tuples<serialize_svb>, roundtrip_tuples<serialize_svb, parse_svb>}),
+        std::make_pair("msgpack"s, BenchEntry{"msgpack", generate_tuples<serialize_msgpack>, parse_tuples<parse_msgpack>, serialize_tuples<serialize_msgpack>, roundtrip_tuples<serialize_msgpack, parse_msgpack>}),
+        std::make_pair("msgpackfast"s, BenchEntry{"msgpack", generate_tuples<serialize_msgpack>, parse_tuples<parse_msgpack_fast>, serialize_tuples<serialize_msgpack>, roundtrip_tuples<serialize_msgpack, parse_msgpack_fast>, false, false, true}),
+        std::make_pair("cbor"s, BenchEntry{"cbor", generate_tuples<serialize_cbor>, parse_tuples<parse_cbor>, serialize_tuples<serialize_cbor>, roundtrip_tuples<serialize_cbor, parse_cbor>}),
+        std::make_pair("cborfast"s, BenchEntry{"cbor", generate_tuples<serialize_cbor>, parse_tuples<parse_cbor_fast>, serialize_tuples<serialize_cbor>, roundtrip_tuples<serialize_cbor, parse_cbor_fast>, false, false, true}),
+
+        std::make_pair("csvstd"s, BenchEntry{"csv", generate_tuples<serialize_csv>, parse_tuples<parse_csv_std>, serialize_tuples<serialize_csv>, roundtrip_tuples<serialize_csv, parse_csv_std>}),
+        std::make_pair("csvfastfloat"s, BenchEntry{"csv", generate_tuples<serialize_csv>, parse_tuples<parse_csv_fast_float>, serialize_tuples<serialize_csv>, roundtrip_tuples<serialize_csv, parse_csv_fast_float>}),
+        std::make_pair("csvfastfloatcustom"s, BenchEntry{"csv", generate_tuples<serialize_csv>, parse_tuples<parse_csv_fast_float_custom>, serialize_tuples<serialize_csv>, roundtrip_tuples<serialize_csv, parse_csv_fast_float_custom>}),
+        std::make_pair("csvbenstrasser"s, BenchEntry{"csv", generate_tuples<serialize_csv>, parse_tuples<parse_csv_benstrasser>, serialize_tuples<serialize_csv>, roundtrip_tuples<serialize_csv, parse_csv_benstrasser>}),
+        std::make_pair("csvsimd"s, BenchEntry{"csv-lines", generate_tuples<serialize_csv_dialect>, parse_tuple_batches<parse_csv_simd>, serialize_tuples<serialize_csv_dialect>, roundtrip_tuple_batches<serialize_csv_dialect, parse_csv_simd>, true}),
+
+        std::make_pair("schemacsv"s, BenchEntry{"csv", generate_tuples<serialize_csv_schema<NativeTupleSchema>>, parse_tuples<parse_csv_schema<NativeTupleSchema>>, serialize_tuples<serialize_csv_schema<NativeTupleSchema>>, roundtrip_tuples<serialize_csv_schema<NativeTupleSchema>, parse_csv_schema<NativeTupleSchema>>}),
+        std::make_pair("schemajson"s, BenchEntry{"json", generate_tuples<serialize_json_schema<NativeTupleSchema>>, parse_tuples<parse_simdjson_schema<NativeTupleSchema>>, serialize_tuples<serialize_json_schema<NativeTupleSchema>>, roundtrip_tuples<serialize_json_schema<NativeTupleSchema>, parse_simdjson_schema<NativeTupleSchema>>}),
+        std::make_pair("schemajsonsax"s, BenchEntry{"json", generate_tuples<serialize_json_schema<NativeTupleSchema>>, parse_tuples<parse_rapidjson_sax_schema<NativeTupleSchema>>, serialize_tuples<serialize_json_schema<NativeTupleSchema>>, roundtrip_tuples<serialize_json_schema<NativeTupleSchema>, parse_rapidjson_sax_schema<NativeTupleSchema>>}),
+
+        std::make_pair("widecsv"s, BenchEntry{"wide-csv", generate_schema_tuples<WideTupleSchema, serialize_csv_schema<WideTupleSchema>>, parse_schema_tuples<WideTupleSchema, parse_csv_schema<WideTupleSchema>>, nullptr, nullptr, false, true}),
+        std::make_pair("widejson"s, BenchEntry{"wide-json", generate_schema_tuples<WideTupleSchema, serialize_json_schema<WideTupleSchema>>, parse_schema_tuples<WideTupleSchema, parse_simdjson_schema<WideTupleSchema>>, nullptr, nullptr, false, true}),
+        std::make_pair("widejsonsax"s, BenchEntry{"wide-json", generate_schema_tuples<WideTupleSchema, serialize_json_schema<WideTupleSchema>>, parse_schema_tuples<WideTupleSchema, parse_rapidjson_sax_schema<WideTupleSchema>>, nullptr, nullptr, false, true}),
+        std::make_pair("widenative"s, BenchEntry{"wide-native", generate_schema_tuples<WideTupleSchema, serialize_native_schema<WideTupleSchema>>, parse_schema_tuples<WideTupleSchema, parse_native_schema<WideTupleSchema>>, nullptr, nullptr, false, true}),
+
+        std::make_pair("stringscsv"s, BenchEntry{"strings-csv", generate_schema_tuples<StringTupleSchema, serialize_csv_schema<StringTupleSchema>>, parse_schema_tuples<StringTupleSchema, parse_csv_schema<StringTupleSchema>>, nullptr, nullptr, false, true}),
+        std::make_pair("stringsjson"s, BenchEntry{"strings-json", generate_schema_tuples<StringTupleSchema, serialize_json_schema<StringTupleSchema>>, parse_schema_tuples<StringTupleSchema, parse_simdjson_schema<StringTupleSchema>>, nullptr, nullptr, false, true}),
+        std::make_pair("stringsjsonsax"s, BenchEntry{"strings-json", generate_schema_tuples<StringTupleSchema, serialize_json_schema<StringTupleSchema>>, parse_schema_tuples<StringTupleSchema, parse_rapidjson_sax_schema<StringTupleSchema>>, nullptr, nullptr, false, true}),
+        std::make_pair("stringsnative"s, BenchEntry{"strings-native", generate_schema_tuples<StringTupleSchema, serialize_native_schema<StringTupleSchema>>, parse_schema_tuples<StringTupleSchema, parse_native_schema<StringTupleSchema>>, nullptr, nullptr, false, true}),
+    };
+    // clang-format on
+
+    // Generators for --framing, one record per line. rapidjson needs null-terminated input and
+    // batched parsers find the record boundaries by themselves, so they don't take part.
+    const std::map framed_generators{
+        std::make_pair("csv"sv, generate_tuples<serialize_csv_line>),
+        std::make_pair("json"sv, generate_tuples<serialize_ndjson>),
+    };
+    const std::set unframed_parsers{
+        "rapidjson"sv, "rapidjsoninsitu"sv, "rapidjsonsax"sv, "schemajsonsax"sv};
+
+    const auto supports_framing = [&](const std::string& name, const BenchEntry& entry) {
+        return framed_generators.count(entry.format) != 0 && unframed_parsers.count(name) == 0 &&
+               !entry.batched;
+    };
+
+    // Parse runs over the whole dataset, one tuple after the other.
+    const bool whole_dataset_run = settings.mode == BenchMode::parse && !parse_options.framed &&
+                                   settings.pipeline_chunk_tuples == 0 &&
+                                   settings.ingest_mode == IngestMode::memory &&
+                                   parse_options.latency_sample_interval == 0 &&
+                                   settings.codec == Codec::none;
+    // The only runs parsers of wider schemas support: see parse_schema_tuples.
+    const bool plain_run = whole_dataset_run && parse_options.sink != OutputSink::soa;
+    // The only runs record batches support: see parse_record_batches.
+    const bool record_batch_run = whole_dataset_run && settings.numa_mode != NumaMode::partition;
+
+    // Parsers in the order given, grouped by format so every dataset is only generated once.
+    std::vector<std::string> parser_names;
+    {
+        const auto parser_list = arguments["parser"].as<std::string>();
+        if (parser_list == "all") {
+            for (const auto& [name, entry] : generator_parser_map) {
+                if ((!parse_options.framed || supports_framing(name, entry)) &&
+                    ((settings.ingest_mode == IngestMode::memory &&
+                      settings.codec == Codec::none) ||
+                     !entry.batched) &&
+                    (plain_run || !entry.schema_tuples) &&
+                    (record_batch_run || !entry.record_batches)) {
+                    parser_names.push_back(name);
+                }
+            }
+        } else {
+            parser_names = split_comma_list(parser_list);
+        }
+    }
+    std::vector<std::pair<std::string_view, std::vector<std::string>>> format_groups;
+    for (const auto& parser_name : parser_names) {
+        const auto it = generator_parser_map.find(parser_name);
+        if (it == generator_parser_map.end()) {
+            fmt::print(stderr, "Invalid argument for parser: {}.\n", parser_name);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        if (parse_options.framed && !supports_framing(parser_name, it->second)) {
+            fmt::print(stderr, "Parser {} does not support --framing.\n", parser_name);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        if (settings.ingest_mode != IngestMode::memory && it->second.batched) {
+            fmt::print(stderr, "Parser {} does not support --ingest.\n", parser_name);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        if (settings.codec != Codec::none && it->second.batched) {
+            fmt::print(stderr, "Parser {} does not support --compress.\n", parser_name);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        if (!plain_run && it->second.schema_tuples) {
+            fmt::print(stderr,
+                       "Parser {} only supports --mode parse into the discard or aos sink, without "
+                       "--pipeline, --framing, --latency-sample, --ingest or --compress.\n",
+                       parser_name);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        if (!record_batch_run && it->second.record_batches) {
+            fmt::print(stderr,
+                       "Parser {} only supports --mode parse, without --pipeline, --framing, "
+                       "--latency-sample, --ingest, --compress or --numa partition.\n",
+                       parser_name);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        const auto group =
+            std::find_if(begin(format_groups), end(format_groups),
+                         [&](const auto& group) { return group.first == it->second.format; });
+        if (group == end(format_groups)) {
+            format_groups.emplace_back(it->second.format, std::vector{parser_name});
+        } else {
+            group->second.push_back(parser_name);
+        }
+    }
+
+    if (format_groups.size() > 1 &&
+        (arguments.count("dataset-in") != 0 || arguments.count("dataset-out") != 0)) {
+        fmt::print(stderr, "Dataset files hold a single format, but the parsers need {}.\n",
+                   format_groups.size());
+        exit(1);  // NOLINT(concurrency-mt-unsafe)
+    }
+
+    // simdjson's On Demand API is bound to the implementation of the -march it was built with.
+    const std::string simdjson_name = simdjson::builtin_implementation()->name();
+    if (simdjson_name != "haswell" && simdjson_name != "icelake") {
+        fmt::print(stderr,
+                   "\nWARNING\nsimdjson implementation: {} (should be haswell or icelake, "
+                   "the other kernels use {})\n\n",
+                   simdjson_name, settings.isa_name);
+    }
+
+    std::vector<RunResult> run_results;
+    for (const auto& [format, group_parser_names] : format_groups) {
+        const BenchEntry& entry = generator_parser_map.at(group_parser_names.front());
+        const GeneratorFunc generate =
+            parse_options.framed ? framed_generators.at(format) : entry.generate;
+        const std::string dataset_format =
+            parse_options.framed ? fmt::format("{}-lines", format) : std::string(format);
+        // Dialect the csv-lines tuples are written in: framed csv is always in the default one.
+        const std::string needed_csv_dialect =
+            dataset_format != "csv-lines" ? ""
+            : parse_options.framed        ? csv_dialect_name(CsvDialect{})
+                                          : settings.csv_dialect_name;
+
+        /*
+         * Input Data Generation
+         */
+        std::vector<std::byte> memory;
+        std::vector<tuple_size_t> tuple_sizes;
+        std::optional<MappedDataset> mapped_dataset;
+        DatasetView dataset;
+        uint64_t seed = 0;
+        std::string dataset_path;
+        uint64_t dataset_memory_offset = 0;
+
+        if (arguments.count("dataset-in") != 0) {
+            const auto path = arguments["dataset-in"].as<std::string>();
+            const auto timestamp = std::chrono::high_resolution_clock::now();
+            try {
+                mapped_dataset.emplace(path);
+            } catch (const std::runtime_error& e) {
+                fmt::print(stderr, "{}\n", e.what());
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+
+            if (mapped_dataset->header().format_name() != dataset_format) {
+                fmt::print(stderr, "Dataset {} contains {} tuples, parser {} needs {} tuples.\n",
+                           path, mapped_dataset->header().format_name(),
+                           group_parser_names.front(), dataset_format);
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+            // The file knows the workload of its tuples, which text formats print and serialize
+            // mode generates again.
+            const std::string_view file_workload = mapped_dataset->header().workload_name();
+            if (file_workload != settings.workload_name) {
+                if (workload_given) {
+                    fmt::print(stderr, "Dataset {} contains workload {}, but {} was given.\n",
+                               path, file_workload, settings.workload_name);
+                    exit(1);  // NOLINT(concurrency-mt-unsafe)
+                }
+                const size_t slash = file_workload.find('/');
+                select_workload(std::string(file_workload.substr(0, slash)),
+                                std::string(file_workload.substr(slash + 1)));
+            }
+            // csvsimd parses the dialect of the file, the framed parsers only the default one.
+            const std::string_view file_csv_dialect = mapped_dataset->header().csv_dialect_name();
+            if (dataset_format == "csv-lines" && file_csv_dialect != needed_csv_dialect) {
+                const size_t slash = file_csv_dialect.rfind('/');
+                const auto dialect =
+                    slash == std::string_view::npos
+                        ? std::nullopt
+                        : parse_csv_dialect(file_csv_dialect.substr(0, slash),
+                                            file_csv_dialect.substr(slash + 1));
+                if (!dialect || csv_dialect_given || parse_options.framed) {
+                    fmt::print(stderr, "Dataset {} contains csv dialect {}, but {} is needed.\n",
+                               path, file_csv_dialect, needed_csv_dialect);
+                    exit(1);  // NOLINT(concurrency-mt-unsafe)
+                }
+                parse_options.csv_dialect = *dialect;
+                settings.csv_dialect_name = csv_dialect_name(*dialect);
+            }
+            dataset = mapped_dataset->view();
+            seed = mapped_dataset->header().seed;
+            dataset_path = path;
+            dataset_memory_offset = mapped_dataset->header().memory_offset;
+
+            const std::chrono::duration<double> elapsed_seconds =
+                std::chrono::high_resolution_clock::now() - timestamp;
+            fmt::print(stderr, "Mapped {} tuples ({} B, seed {}, workload {}) from {} in {}s.\n",
+                       dataset.tuple_sizes.size(), dataset.memory.size(),
+                       mapped_dataset->header().seed, settings.workload_name, path,
+                       elapsed_seconds.count());
+        } else {
+            memory.reserve(memory_bytes + MEMORY_PADDING);
+            tuple_sizes.reserve(memory_bytes / 64);
+
+            GeneratorOptions generator_options;
+            generator_options.thread_count =
+                std::max(1U, std::thread::hardware_concurrency() - 1);
+            generator_options.seed = arguments.count("seed") != 0
+                                         ? arguments["seed"].as<uint64_t>()
+                                         : std::random_device{}();
+            generator_options.cpus = pin_order;
+            generator_options.profile = settings.workload;
+            generator_options.csv_dialect = parse_options.csv_dialect;
+            generator_options.record_batch_tuples = settings.record_batch_tuples;
+            seed = generator_options.seed;
+
+            fmt::print(stderr,
+                       "Generating {} tuples for {} B of memory using {} threads, seed {}, "
+                       "workload {}.\n",
+                       dataset_format, memory_bytes, generator_options.thread_count,
+                       generator_options.seed, settings.workload_name);
+            const auto timestamp = std::chrono::high_resolution_clock::now();
+
+            generate(&memory, memory_bytes, &tuple_sizes, generator_options);
+
+            const std::chrono::duration<double> elapsed_seconds =
+                std::chrono::high_resolution_clock::now() - timestamp;
+            fmt::print(stderr, "Generated {} tuples ({} B) in {}s.\n", tuple_sizes.size(),
+                       memory.size(), elapsed_seconds.count());
+            // fmt::print("Memory contents:\n{}\n", (char*)(memory.data()));
+            // fmt::print("Tuple sizes: {}\n", fmt::join(tuple_sizes, ", "));
+
+            dataset = {memory, tuple_sizes};
+
+            if (arguments.count("dataset-out") != 0) {
+                const auto path = arguments["dataset-out"].as<std::string>();
+                try {
+                    dataset_memory_offset =
+                        write_dataset(path, dataset_format, settings.workload_name,
+                                      needed_csv_dialect, generator_options.seed, dataset)
+                            .memory_offset;
+                    dataset_path = path;
+                } catch (const std::runtime_error& e) {
+                    fmt::print(stderr, "{}\n", e.what());
+                    exit(1);  // NOLINT(concurrency-mt-unsafe)
+                }
+                fmt::print(stderr, "Wrote dataset to {}.\n", path);
+            }
+        }
+
+        PlacedInput input = place_input(dataset, seed, settings);
+        input.dataset_path = dataset_path;
+        input.dataset_memory_offset = dataset_memory_offset;
+        if (settings.numa_mode != NumaMode::off) {
+            // The node copies are all that is parsed from here on.
+            memory = {};
+            tuple_sizes = {};
+            mapped_dataset.reset();
+        }
+        if (settings.codec != Codec::none) {
+            const auto timestamp = std::chrono::high_resolution_clock::now();
+            try {
+                input.compressed = compress_dataset(dataset, settings.codec,
+                                                    settings.compress_block_size,
+                                                    settings.compress_level);
+            } catch (const std::runtime_error& e) {
+                fmt::print(stderr, "{}\n", e.what());
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+            const std::chrono::duration<double> elapsed_seconds =
+                std::chrono::high_resolution_clock::now() - timestamp;
+            fmt::print(stderr,
+                       "Compressed {} B into {} B in {} blocks with {} in {}s: ratio {:.3f}.\n",
+                       input.compressed.raw_size, input.compressed.memory.size(),
+                       input.compressed.blocks.size(), settings.compress_name,
+                       elapsed_seconds.count(),
+                       static_cast<double>(input.compressed.raw_size) /
+                           static_cast<double>(input.compressed.memory.size()));
+        }
+        if (settings.mode != BenchMode::parse) {
+            // The generator derives every tuple from seed, index and workload alone, so these are
+            // exactly the tuples of the dataset, also for a mapped one.
+            input.native_tuples.reserve(input.tuple_count);
+            for (size_t i = 0; i < input.tuple_count; ++i) {
+                input.native_tuples.push_back(generate_native_tuple(seed, i, settings.workload));
+            }
+        }
+
+        /*
+         * Actual Benchmark
+         */
+        // Most parsers of a format share the serializer, so serialize runs once per serializer:
+        // named after the format, further ones (e.g. schemacsv's) after their first parser.
+        std::vector<std::pair<std::string, std::string>> runs;  // run name and parser name
+        if (settings.mode == BenchMode::serialize) {
+            std::vector<TupleRunnerFunc> serializers;
+            for (const auto& parser_name : group_parser_names) {
+                const TupleRunnerFunc serialize = generator_parser_map.at(parser_name).serialize;
+                if (std::find(begin(serializers), end(serializers), serialize) !=
+                    end(serializers)) {
+                    continue;
+                }
+                runs.emplace_back(serializers.empty() ? std::string(format) : parser_name,
+                                  parser_name);
+                serializers.push_back(serialize);
+            }
+        } else {
+            for (const auto& parser_name : group_parser_names) {
+                runs.emplace_back(parser_name, parser_name);
+            }
+        }
+        for (const auto& [run_name, parser_name] : runs) {
+            const size_t first_run = run_results.size();
+            for (const size_t thread_count : thread_counts) {
+                run_results.push_back(run_benchmark(run_name,
+                                                    generator_parser_map.at(parser_name), input,
+                                                    thread_count, settings));
+            }
+            if (thread_counts.size() > 1) {
+                report_scaling(run_name, thread_counts,
+                               std::span(run_results).subspan(first_run),
+                               arguments["efficiency-threshold"].as<double>());
+            }
+        }
+    }
+
+    if (run_results.size() > 1) {
+        print_comparison_table(stderr, run_results);
+    }
+
+    if (output_format) {
+        const auto path = arguments["output-file"].as<std::string>();
+        std::FILE* const out = path == "-" ? stdout : std::fopen(path.c_str(), "w");
+        if (out == nullptr) {
+            fmt::print(stderr, "Could not open {} for writing.\n", path);
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        if (*output_format == "json") {
+            write_results_json(out, run_results);
+        } else {
+            write_results_csv(out, run_results);
+        }
+        if (out != stdout) {
+            std::fclose(out);
+        }
+    }
 }
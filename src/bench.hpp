@@ -1,18 +1,31 @@
 #pragma once
 
 #include <fmt/format.h>
+#include <sched.h>
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <bit>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <limits>
-#include <mutex>
-#include <random>
+#include <numeric>
+#include <span>
 #include <thread>
+#include <utility>
 #include <vector>
 
+#include "compression.hpp"
 #include "constants.hpp"
+#include "csv_simd.hpp"
+#include "framing.hpp"
+#include "ingest.hpp"
+#include "kernels.hpp"
+#include "latency.hpp"
 #include "parse.hpp"
+#include "workload.hpp"
 
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define likely(x) __builtin_expect(!!(x), 1)
@@ -24,18 +37,30 @@ constexpr size_t HASH_BYTES = 32;  // 256bit = 32 byte
 
 using tuple_size_t = uint_fast16_t;
 
-template <class InputIt, class Pred>
-bool vectorizable_any_of(InputIt first, InputIt last, Pred pred) {
-    // supposed to replace:
-    // std::any_of(std::execution::unseq, first, last, pred);
-    // on environments where std::execution is not yet available (node-01: gcc09, no <execution>)
-    // 18% faster than std::any_of on t460 with clang13, O3, measuring simdjson (0,81 vs 0,96)
+// Parses the 2 * N hex characters at str into bytes.
+template <size_t N>
+[[nodiscard]] std::from_chars_result parse_hex_bytes(const char* str,
+                                                     const char* str_end,
+                                                     std::array<std::byte, N>* bytes) {
+    if (unlikely((str_end - str) < static_cast<ptrdiff_t>(2 * N))) {
+        return {nullptr, std::errc::invalid_argument};
+    }
 
-    bool val = false;
-    for (; first != last; ++first) {
-        val |= pred(*first);
+    if constexpr (use_std_from_chars) {
+        for (size_t i = 0; i < N; ++i) {
+            auto result = std::from_chars(str + 2 * i, str + 2 * i + 2,
+                                          reinterpret_cast<unsigned char&>((*bytes)[i]), 16);
+            if (result.ec != std::errc()) {
+                return result;
+            }
+        }
+    } else {
+        // dispatched: one indirect call per hex string, selected with --isa
+        if (unlikely(!kernels.decode_hex(str, N, bytes->data()))) {
+            return {nullptr, std::errc::invalid_argument};
+        }
     }
-    return val;
+    return {str + 2 * N, std::errc()};
 }
 
 struct NativeTuple {
@@ -49,31 +74,7 @@ struct NativeTuple {
 
     [[nodiscard]] std::from_chars_result set_container_id_from_hex_string(const char* str,
                                                                           const char* str_end) {
-        if (unlikely((str_end - str) < static_cast<ptrdiff_t>(2 * HASH_BYTES))) {
-            return {nullptr, std::errc::invalid_argument};
-        }
-
-        if constexpr (use_std_from_chars) {
-            for (size_t i = 0; i < HASH_BYTES; ++i) {
-                auto result =
-                    std::from_chars(str + 2 * i, str + 2 * i + 2,
-                                    reinterpret_cast<unsigned char&>(container_id[i]), 16);
-                if (result.ec != std::errc()) {
-                    return result;
-                }
-            }
-        } else {
-            if (unlikely(vectorizable_any_of(str, str + 2 * HASH_BYTES,
-                                             [](const char c) { return !is_hex_char(c); }))) {
-                return {nullptr, std::errc::invalid_argument};
-            }
-
-            for (size_t i = 0; i < HASH_BYTES; ++i) {
-                reinterpret_cast<unsigned char&>(container_id[i]) =
-                    parse_hex_char(str[2 * i]) * 16 + parse_hex_char(str[2 * i + 1]);
-            }
-        }
-        return {str + 2 * HASH_BYTES, std::errc()};
+        return parse_hex_bytes(str, str_end, &container_id);
     }
 };
 
@@ -117,89 +118,612 @@ constexpr size_t cacheline_size = 64;
 struct ThreadResult {
     alignas(cacheline_size) std::atomic<size_t> tuples_read = 0;
     alignas(cacheline_size) std::atomic<size_t> bytes_read = 0;
+    // TSC ticks spent finding record boundaries and parsing records in framed mode.
+    alignas(cacheline_size) std::atomic<uint64_t> scan_cycles = 0;
+    alignas(cacheline_size) std::atomic<uint64_t> parse_cycles = 0;
+    // TSC ticks spent decompressing blocks with --compress.
+    alignas(cacheline_size) std::atomic<uint64_t> decompress_cycles = 0;
+    // Tuples a parser with a speculative fast path handed to its generic fallback.
+    alignas(cacheline_size) std::atomic<uint64_t> fallback_tuples = 0;
+    // TSC ticks of sampled parse() calls. Only touched by the parser thread until it is joined.
+    alignas(cacheline_size) LatencyHistogram latency;
 };
 
-using SerializerFunc = void (*)(const NativeTuple&, std::vector<std::byte>*);
-template <SerializerFunc serialize>
-void generate_tuples(std::vector<std::byte>* memory,
-                     size_t target_memory_size,
-                     std::vector<tuple_size_t>* tuple_sizes,
-                     std::mutex* mutex) {
-    std::mt19937_64 gen(std::random_device{}());
-    auto load_distribution = [](std::mt19937_64& generator) {
-        return static_cast<double>(generator()) / static_cast<double>(std::mt19937_64::max());
+// Counted by parsers with a speculative fast path (jsonfastpath, msgpackfast, cborfast) on their
+// thread, moved to ThreadResult::fallback_tuples by the tuple-at-a-time runners once per run.
+inline thread_local uint64_t thread_fallback_tuples = 0;
+
+inline void flush_fallback_tuples(ThreadResult* result) {
+    result->fallback_tuples.fetch_add(std::exchange(thread_fallback_tuples, 0),
+                                      std::memory_order_relaxed);
+}
+
+// Parsers may read this many bytes past the end of the last tuple (simdjson padding, the
+// rapidjsoninsitu copy), so every buffer holding tuples has to have this much slack.
+constexpr size_t MEMORY_PADDING = 1024;
+
+// Read-only view of the generated tuples. Backed either by the generator's vectors or by a mapped
+// dataset file.
+struct DatasetView {
+    std::span<const std::byte> memory;
+    std::span<const tuple_size_t> tuple_sizes;
+};
+
+// Tuples [first_tuple, last_tuple) of a dataset. The slice still has MEMORY_PADDING readable bytes
+// behind it: either the following tuples or the padding of the whole dataset.
+inline DatasetView slice_dataset(const DatasetView& dataset,
+                                 size_t first_tuple,
+                                 size_t last_tuple) {
+    const auto sizes = dataset.tuple_sizes;
+    const size_t begin_offset =
+        std::accumulate(sizes.begin(), sizes.begin() + first_tuple, size_t{0});
+    const size_t end_offset =
+        std::accumulate(sizes.begin() + first_tuple, sizes.begin() + last_tuple, begin_offset);
+    return {dataset.memory.subspan(begin_offset, end_offset - begin_offset),
+            sizes.subspan(first_tuple, last_tuple - first_tuple)};
+}
+
+// Counter-based random number generator: the n-th number of the stream of a seed only depends on
+// (seed, n), so any position of the stream can be jumped to in constant time. This is SplitMix64
+// (https://prng.di.unimi.it/splitmix64.c) with an explicit counter.
+class CounterRng {
+   public:
+    using result_type = uint64_t;
+
+    CounterRng(uint64_t seed, uint64_t counter) : seed_(seed), counter_(counter) {}
+
+    static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        uint64_t z = seed_ + (++counter_ * 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27U)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31U);
+    }
+
+   private:
+    uint64_t seed_;
+    uint64_t counter_;
+};
+
+// Restricts the calling thread to a single CPU.
+inline void pin_current_thread_to_cpu(size_t cpu) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+        fmt::print(stderr, "WARNING: could not pin thread to CPU {}\n", cpu);
+    }
+}
+
+// Lets the calling thread run on any CPU again.
+inline void unpin_current_thread() {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        CPU_SET(cpu, &cpu_set);
+    }
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+        fmt::print(stderr, "WARNING: could not unpin thread\n");
+    }
+}
+
+struct GeneratorOptions {
+    uint64_t seed = 0;
+    size_t thread_count = 1;
+    std::vector<size_t> cpus;  // generator thread i runs on cpus[i % size], unpinned if empty
+    WorkloadProfile profile;
+    CsvDialect csv_dialect;             // of the csv-lines format
+    size_t record_batch_tuples = 1024;  // per batch of the columnar format
+};
+
+// Every tuple draws this many numbers from its own part of the random stream.
+constexpr uint64_t RANDOM_NUMBERS_PER_TUPLE = 16;
+
+inline uint64_t profile_id(IdDistribution distribution, uint64_t draw, uint64_t tuple_index) {
+    switch (distribution) {
+        case IdDistribution::small:
+            return draw % SMALL_ID_LIMIT;
+        case IdDistribution::sequential:
+            return tuple_index;
+        case IdDistribution::uniform:
+        default:
+            return draw;
+    }
+}
+
+inline uint64_t profile_timestamp(TimestampDistribution distribution,
+                                  uint64_t draw,
+                                  uint64_t tuple_index) {
+    switch (distribution) {
+        case TimestampDistribution::monotonic:
+            // The jitter stays below the interval, so the timestamps never decrease.
+            return TIMESTAMP_EPOCH_MS + tuple_index * TIMESTAMP_INTERVAL_MS +
+                   draw % TIMESTAMP_INTERVAL_MS;
+        case TimestampDistribution::uniform:
+        default:
+            return draw;
+    }
+}
+
+// Printing with two decimals rounds anyway, this keeps the native tuples equal to the parsed ones.
+inline float profile_round(FloatFormat format, float value) {
+    return format == FloatFormat::two_decimals ? std::round(value * 100) / 100 : value;
+}
+
+// Every field draws the same numbers under each profile, so the container ids do not change.
+inline NativeTuple generate_native_tuple(uint64_t seed,
+                                         uint64_t tuple_index,
+                                         const WorkloadProfile& profile = {}) {
+    CounterRng gen(seed, tuple_index * RANDOM_NUMBERS_PER_TUPLE);
+    auto load_distribution = [](CounterRng& generator) {
+        return static_cast<double>(generator()) / static_cast<double>(CounterRng::max());
     };
 
-    std::vector<std::byte> local_buffer;
-    std::vector<tuple_size_t> local_tuple_sizes;
-    local_buffer.reserve(256 * generate_chunk_size);
-    local_tuple_sizes.reserve(generate_chunk_size);
-
-    while (true) {
-        local_buffer.clear();
-        local_tuple_sizes.clear();
-
-        for (uint64_t i = 0; i < generate_chunk_size; ++i) {
-            NativeTuple tup;  // NOLINT(cppcoreguidelines-pro-type-member-init)
-            tup.id = gen();
-            tup.timestamp = gen();
-            tup.load = load_distribution(gen);
-            tup.load_avg_1 = load_distribution(gen);
-            tup.load_avg_5 = load_distribution(gen);
-            tup.load_avg_15 = load_distribution(gen);
-            static_assert(HASH_BYTES % 8 == 0);
-            std::generate_n(reinterpret_cast<uint64_t*>(tup.container_id.data()),
-                            sizeof(tup.container_id) / sizeof(tup.container_id[0]) / 8,
-                            std::ref(gen));
-
-            auto old_size = static_cast<int64_t>(local_buffer.size());
-            serialize(tup, &local_buffer);
-            tuple_size_t tup_size = local_buffer.size() - old_size;
-            local_tuple_sizes.push_back(tup_size);
+    NativeTuple tup;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+    tup.id = profile_id(profile.ids, gen(), tuple_index);
+    tup.timestamp = profile_timestamp(profile.timestamps, gen(), tuple_index);
 
-            if constexpr (debug_output) {
-                fmt::print("Serialized {}\n", tup);
-            }
-        }
-
-        {
-            std::scoped_lock lock(*mutex);
-            if (memory->size() + local_buffer.size() <= target_memory_size) {
-                auto old_memory_size = static_cast<int64_t>(memory->size());
-                auto old_tuple_sizes_size = static_cast<int64_t>(tuple_sizes->size());
-                memory->resize(old_memory_size + local_buffer.size());
-                tuple_sizes->resize(old_tuple_sizes_size + local_tuple_sizes.size());
-
-                std::copy(begin(local_buffer), end(local_buffer), begin(*memory) + old_memory_size);
-                std::copy(begin(local_tuple_sizes), end(local_tuple_sizes),
-                          begin(*tuple_sizes) + old_tuple_sizes_size);
-            } else {
-                auto read_it = begin(local_buffer);
-                for (const auto& tup_size : local_tuple_sizes) {
-                    if (memory->size() + tup_size > target_memory_size) {
-                        return;
-                    }
-                    std::copy_n(read_it, tup_size, std::back_inserter(*memory));
-                    tuple_sizes->push_back(tup_size);
-                    read_it += static_cast<int64_t>(tup_size);
+    const double load = load_distribution(gen);
+    const double load_avg_1 = load_distribution(gen);
+    const double load_avg_5 = load_distribution(gen);
+    const double load_avg_15 = load_distribution(gen);
+    switch (profile.loads) {
+        case LoadDistribution::unit:
+            tup.load = load;
+            tup.load_avg_1 = load_avg_1;
+            tup.load_avg_5 = load_avg_5;
+            tup.load_avg_15 = load_avg_15;
+            break;
+        case LoadDistribution::realistic:
+            // The shorter averages stay within +-25% of the longer ones.
+            tup.load = load * 100;
+            tup.load_avg_15 = load_avg_15 * 16;
+            tup.load_avg_5 = tup.load_avg_15 * (0.75 + load_avg_5 / 2);
+            tup.load_avg_1 = tup.load_avg_5 * (0.75 + load_avg_1 / 2);
+            break;
+    }
+    for (float* value : {&tup.load, &tup.load_avg_1, &tup.load_avg_5, &tup.load_avg_15}) {
+        *value = profile_round(profile.floats, *value);
+    }
+
+    static_assert(HASH_BYTES % 8 == 0);
+    static_assert(6 + HASH_BYTES / 8 <= RANDOM_NUMBERS_PER_TUPLE);
+    std::generate_n(reinterpret_cast<uint64_t*>(tup.container_id.data()),
+                    sizeof(tup.container_id) / sizeof(tup.container_id[0]) / 8, std::ref(gen));
+    return tup;
+}
+
+// Fills `memory` with up to `target_memory_size` bytes of tuples, calling produce(tuple_index, buf)
+// to append tuple number 0, 1, 2, ... to buf. The result only depends on `produce`, not on the
+// thread count or scheduling.
+//
+// Threads claim chunks of generate_chunk_size consecutive tuple indices from an atomic counter and
+// append them to their own arena, so there is no lock and no shared buffer while generating. Once
+// enough bytes exist, a prefix sum over the chunk sizes gives every chunk its final position and
+// each thread copies its own chunks there.
+template <typename Produce>
+void generate_dataset(std::vector<std::byte>* memory,
+                      size_t target_memory_size,
+                      std::vector<tuple_size_t>* tuple_sizes,
+                      const GeneratorOptions& options,
+                      const Produce& produce) {
+    struct Chunk {
+        size_t thread;
+        size_t arena_offset;
+        size_t sizes_offset;
+        size_t byte_count;
+        size_t tuple_count;
+        // set while stitching
+        size_t memory_offset;
+        size_t tuple_offset;
+    };
+    struct Arena {
+        std::vector<std::byte> bytes;
+        std::vector<tuple_size_t> sizes;
+        std::vector<std::pair<size_t, Chunk>> chunks;  // (chunk index, chunk)
+    };
+
+    const size_t thread_count = options.thread_count;
+    const auto pin = [&](size_t thread) {
+        if (!options.cpus.empty()) {
+            pin_current_thread_to_cpu(options.cpus[thread % options.cpus.size()]);
+        }
+    };
+
+    std::vector<Arena> arenas(thread_count);
+    std::atomic<size_t> next_chunk_index = 0;
+    std::atomic<size_t> generated_bytes = 0;
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+    for (size_t thread = 0; thread < thread_count; ++thread) {
+        threads.emplace_back([&, thread] {
+            pin(thread);
+            Arena& arena = arenas[thread];
+            arena.bytes.reserve(target_memory_size / thread_count + 256 * generate_chunk_size);
+
+            while (generated_bytes.load(std::memory_order_relaxed) < target_memory_size) {
+                const size_t chunk_index = next_chunk_index.fetch_add(1);
+                Chunk chunk{thread, arena.bytes.size(), arena.sizes.size(), 0, 0, 0, 0};
+
+                for (uint64_t i = 0; i < generate_chunk_size; ++i) {
+                    const size_t old_size = arena.bytes.size();
+                    produce(chunk_index * generate_chunk_size + i, &arena.bytes);
+                    arena.sizes.push_back(arena.bytes.size() - old_size);
                 }
+
+                chunk.byte_count = arena.bytes.size() - chunk.arena_offset;
+                chunk.tuple_count = generate_chunk_size;
+                arena.chunks.emplace_back(chunk_index, chunk);
+                generated_bytes.fetch_add(chunk.byte_count, std::memory_order_relaxed);
             }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+
+    // All claimed chunks are complete, so they form a gapless prefix of the tuple indices.
+    std::vector<Chunk> chunks(next_chunk_index.load());
+    for (const auto& arena : arenas) {
+        for (const auto& [chunk_index, chunk] : arena.chunks) {
+            chunks[chunk_index] = chunk;
         }
     }
+
+    size_t memory_size = 0;
+    size_t tuple_count = 0;
+    bool truncated = false;
+    for (auto& chunk : chunks) {
+        chunk.memory_offset = memory_size;
+        chunk.tuple_offset = tuple_count;
+
+        if (truncated) {
+            // Smaller tuples of later chunks would still fit, but taking them would leave a gap in
+            // the tuple indices that depends on how many chunks the threads claimed.
+            chunk.byte_count = 0;
+            chunk.tuple_count = 0;
+        } else if (memory_size + chunk.byte_count > target_memory_size) {
+            // Only take the tuples of this chunk that still fit, and none after them.
+            const auto& sizes = arenas[chunk.thread].sizes;
+            size_t fitting_bytes = 0;
+            size_t fitting_tuples = 0;
+            while (fitting_tuples < chunk.tuple_count &&
+                   memory_size + fitting_bytes + sizes[chunk.sizes_offset + fitting_tuples] <=
+                       target_memory_size) {
+                fitting_bytes += sizes[chunk.sizes_offset + fitting_tuples];
+                ++fitting_tuples;
+            }
+            chunk.byte_count = fitting_bytes;
+            chunk.tuple_count = fitting_tuples;
+            truncated = true;
+        }
+
+        memory_size += chunk.byte_count;
+        tuple_count += chunk.tuple_count;
+    }
+
+    memory->resize(memory_size);
+    tuple_sizes->resize(tuple_count);
+
+    for (size_t thread = 0; thread < thread_count; ++thread) {
+        threads.emplace_back([&, thread] {
+            pin(thread);
+            Arena& arena = arenas[thread];
+            for (const auto& indexed_chunk : arena.chunks) {
+                const Chunk& chunk = chunks[indexed_chunk.first];
+                std::copy_n(arena.bytes.begin() + static_cast<int64_t>(chunk.arena_offset),
+                            chunk.byte_count,
+                            memory->begin() + static_cast<int64_t>(chunk.memory_offset));
+                std::copy_n(arena.sizes.begin() + static_cast<int64_t>(chunk.sizes_offset),
+                            chunk.tuple_count,
+                            tuple_sizes->begin() + static_cast<int64_t>(chunk.tuple_offset));
+            }
+            arena = Arena{};
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+using SerializerFunc = void (*)(const NativeTuple&, std::vector<std::byte>*);
+// Serializer of a format that comes in several dialects, only csv-lines so far.
+using DialectSerializerFunc = void (*)(const NativeTuple&,
+                                       const CsvDialect&,
+                                       std::vector<std::byte>*);
+
+// The runners take serializers of both kinds as template argument and call them through these.
+inline void serialize_tuple(SerializerFunc serialize,
+                            const NativeTuple& tup,
+                            const CsvDialect& /*dialect*/,
+                            std::vector<std::byte>* buf) {
+    serialize(tup, buf);
+}
+inline void serialize_tuple(DialectSerializerFunc serialize,
+                            const NativeTuple& tup,
+                            const CsvDialect& dialect,
+                            std::vector<std::byte>* buf) {
+    serialize(tup, dialect, buf);
+}
+
+template <auto serialize>
+void generate_tuples(std::vector<std::byte>* memory,
+                     size_t target_memory_size,
+                     std::vector<tuple_size_t>* tuple_sizes,
+                     const GeneratorOptions& options) {
+    generate_dataset(memory, target_memory_size, tuple_sizes, options,
+                     [&](uint64_t tuple_index, std::vector<std::byte>* buf) {
+                         const NativeTuple tup =
+                             generate_native_tuple(options.seed, tuple_index, options.profile);
+                         serialize_tuple(serialize, tup, options.csv_dialect, buf);
+
+                         if constexpr (debug_output) {
+                             fmt::print("Serialized {}\n", tup);
+                         }
+                     });
 }
 
 constexpr size_t RUN_SIZE = 1024ULL * 16;
 
+struct PipelineLane;
+
+// Where parse_tuples puts the parsed tuples.
+enum class OutputSink {
+    discard,  // stack tuple behind DoNotOptimize: the compiler may drop stores nobody reads
+    aos,      // array of NativeTuple, one slot per tuple of the run
+    soa,      // one array per column, one row per tuple of the run
+};
+
+struct ParseOptions {
+    // Bytes handed to one stage-1 pass of batched parsers (simdjson's document_stream batch_size).
+    // Must be larger than the largest tuple.
+    size_t batch_window = 1000000;
+    OutputSink sink = OutputSink::discard;
+    // Time every n-th parse() call of tuple-at-a-time parsers, 0 disables sampling.
+    size_t latency_sample_interval = 0;
+    // The memory is one newline-delimited stream, tuple sizes have to be found while parsing.
+    bool framed = false;
+    // Set per parser thread in pipeline mode: chunks come from the lane instead of the dataset and
+    // parsed tuples go to the consumer instead of the sink.
+    PipelineLane* pipeline_lane = nullptr;
+    // Set per parser thread in the ingest modes: the dataset arrives as a byte stream from here.
+    IngestReceiver* receiver = nullptr;
+    // Set with --compress: the blocks of the dataset are decompressed before parsing.
+    const CompressedDataset* compressed = nullptr;
+    // Of the csv-lines format, for its serializer and csvsimd.
+    CsvDialect csv_dialect;
+};
+
+// Sinks are allocated once per thread and recycled every RUN_SIZE tuples. store() is used by
+// tuple-at-a-time parsers, batched parsers write a whole run to batch_output() and then call
+// store_batch().
+struct DiscardSink {
+    std::vector<NativeTuple> batch_rows;
+
+    static void store(size_t /*index*/, const NativeTuple& tup) { DoNotOptimize(tup); }
+    NativeTuple* batch_output() {
+        batch_rows.resize(RUN_SIZE);
+        return batch_rows.data();
+    }
+    void store_batch(size_t /*index*/, size_t /*count*/) { DoNotOptimize(batch_rows.data()); }
+    static void flush() {}
+};
+
+struct AosSink {
+    std::vector<NativeTuple> rows = std::vector<NativeTuple>(RUN_SIZE);
+
+    void store(size_t index, const NativeTuple& tup) { rows[index] = tup; }
+    // batched parsers write straight into the rows
+    NativeTuple* batch_output() { return rows.data(); }
+    static void store_batch(size_t /*index*/, size_t /*count*/) {}
+    void flush() { DoNotOptimize(rows.data()); }
+};
+
+struct SoaSink {
+    std::vector<uint64_t> id = std::vector<uint64_t>(RUN_SIZE);
+    std::vector<uint64_t> timestamp = std::vector<uint64_t>(RUN_SIZE);
+    std::vector<float> load = std::vector<float>(RUN_SIZE);
+    std::vector<float> load_avg_1 = std::vector<float>(RUN_SIZE);
+    std::vector<float> load_avg_5 = std::vector<float>(RUN_SIZE);
+    std::vector<float> load_avg_15 = std::vector<float>(RUN_SIZE);
+    std::vector<std::array<std::byte, HASH_BYTES>> container_id =
+        std::vector<std::array<std::byte, HASH_BYTES>>(RUN_SIZE);
+    std::vector<NativeTuple> batch_rows;
+
+    void store(size_t index, const NativeTuple& tup) {
+        id[index] = tup.id;
+        timestamp[index] = tup.timestamp;
+        load[index] = tup.load;
+        load_avg_1[index] = tup.load_avg_1;
+        load_avg_5[index] = tup.load_avg_5;
+        load_avg_15[index] = tup.load_avg_15;
+        container_id[index] = tup.container_id;
+    }
+    NativeTuple* batch_output() {
+        batch_rows.resize(RUN_SIZE);
+        return batch_rows.data();
+    }
+    void store_batch(size_t index, size_t count) {
+        for (size_t i = index; i < index + count; ++i) {
+            store(i, batch_rows[i]);
+        }
+    }
+    void flush() {
+        DoNotOptimize(id.data());
+        DoNotOptimize(timestamp.data());
+        DoNotOptimize(load.data());
+        DoNotOptimize(load_avg_1.data());
+        DoNotOptimize(load_avg_5.data());
+        DoNotOptimize(load_avg_15.data());
+        DoNotOptimize(container_id.data());
+    }
+};
+
+// Runs `body` with a freshly allocated sink of the type selected in the options.
+template <typename Body>
+void with_output_sink(const ParseOptions& options, Body&& body) {
+    switch (options.sink) {
+        case OutputSink::discard: {
+            DiscardSink sink;
+            body(&sink);
+            break;
+        }
+        case OutputSink::aos: {
+            AosSink sink;
+            body(&sink);
+            break;
+        }
+        case OutputSink::soa: {
+            SoaSink sink;
+            body(&sink);
+            break;
+        }
+    }
+}
+
+// Bounded lock-free queue between exactly one pushing and one popping thread. Both sides cache
+// the other side's index and only reload it when the queue looks full / empty.
+template <typename T>
+class SpscRing {
+   public:
+    explicit SpscRing(size_t capacity)
+        : slots_(std::bit_ceil(std::max<size_t>(capacity, 1))), mask_(slots_.size() - 1) {}
+
+    bool try_push(const T& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cached_head_ == slots_.size()) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == slots_.size()) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T* value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
+        }
+        *value = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // May be called from any thread, but is only a snapshot.
+    [[nodiscard]] size_t size() const {
+        const size_t head = head_.load(std::memory_order_acquire);
+        return tail_.load(std::memory_order_acquire) - head;
+    }
+    [[nodiscard]] size_t capacity() const { return slots_.size(); }
+
+   private:
+    std::vector<T> slots_;
+    size_t mask_;
+    // popping side
+    alignas(cacheline_size) std::atomic<size_t> head_ = 0;
+    size_t cached_tail_ = 0;
+    // pushing side
+    alignas(cacheline_size) std::atomic<size_t> tail_ = 0;
+    size_t cached_head_ = 0;
+};
+
+// Parsed tuples of one chunk on their way from a parser to the consumer.
+struct TupleBatch {
+    std::vector<NativeTuple> tuples;
+    size_t count = 0;
+    size_t bytes = 0;
+};
+
+// Pipeline mode: a producer thread replays the dataset as chunks of consecutive tuples, every
+// parser thread owns one lane and turns its chunks into tuple batches, and a consumer thread drains
+// the batches of all lanes and hands them back empty. Each queue has a single pusher and popper.
+struct PipelineLane {
+    PipelineLane(size_t depth, size_t chunk_tuples)
+        : chunks(depth), filled(depth), empty(depth), batches(empty.capacity()) {
+        for (auto& batch : batches) {
+            batch.tuples.resize(chunk_tuples);
+            empty.try_push(&batch);
+        }
+    }
+
+    SpscRing<DatasetView> chunks;  // producer -> parser
+    SpscRing<TupleBatch*> filled;  // parser -> consumer, never full: it fits all batches
+    SpscRing<TupleBatch*> empty;   // consumer -> parser
+    std::vector<TupleBatch> batches;
+    // TSC ticks the parser spent waiting for a chunk or an empty batch
+    alignas(cacheline_size) std::atomic<uint64_t> parser_wait_cycles = 0;
+};
+
+// Backoff for polling loops: pause while a wait is short and yield once it is not, so pipelines
+// with more threads than CPUs still make progress. Measures the TSC ticks spent waiting.
+class SpinWait {
+   public:
+    void wait() {
+        if (spins_ == 0) {
+            start_ = tsc_begin();
+        }
+        if (spins_ < 64) {
+            _mm_pause();
+        } else {
+            std::this_thread::yield();
+        }
+        ++spins_;
+    }
+
+    // Ends the current wait and returns its TSC ticks, 0 if there was none.
+    uint64_t done() {
+        if (spins_ == 0) {
+            return 0;
+        }
+        spins_ = 0;
+        return tsc_end() - start_;
+    }
+
+   private:
+    uint64_t start_ = 0;
+    size_t spins_ = 0;
+};
+
+// Pops from `ring`, waiting while it is empty. Returns false if stop_flag was set while waiting.
+template <typename T>
+bool pop_or_wait(SpscRing<T>* ring,
+                 T* value,
+                 uint64_t* wait_cycles,
+                 const std::atomic<bool>& stop_flag) {
+    SpinWait spin;
+    while (!ring->try_pop(value)) {
+        if (stop_flag.load(std::memory_order_relaxed)) {
+            *wait_cycles += spin.done();
+            return false;
+        }
+        spin.wait();
+    }
+    *wait_cycles += spin.done();
+    return true;
+}
+
 using ParseFunc = bool (*)(const std::byte*, tuple_size_t, NativeTuple*);
-template <ParseFunc parse>
-void parse_tuples(ThreadResult* result,
-                  const std::vector<std::byte>& memory,
-                  const std::vector<tuple_size_t>& tuple_sizes,
-                  const std::atomic<bool>& stop_flag) {
-    const std::byte* const start_ptr = memory.data();
+template <ParseFunc parse, bool sample_latency, typename Sink>
+void parse_tuples_into(Sink* sink,
+                       ThreadResult* result,
+                       const DatasetView& dataset,
+                       size_t sample_interval,
+                       const std::atomic<bool>& stop_flag) {
+    const std::byte* const start_ptr = dataset.memory.data();
     const std::byte* read_ptr = start_ptr;
     size_t tuple_index = 0;
-    const size_t tuple_count = tuple_sizes.size();
+    const size_t tuple_count = dataset.tuple_sizes.size();
+    size_t tuples_until_sample = sample_interval;
 
     while (!stop_flag.load(std::memory_order_relaxed)) {
         size_t total_bytes_read = 0;
@@ -213,12 +737,23 @@ void parse_tuples(ThreadResult* result,
                 tuple_index = 0;
             }
 
-            const tuple_size_t tup_size = tuple_sizes[tuple_index];
+            const tuple_size_t tup_size = dataset.tuple_sizes[tuple_index];
 
             NativeTuple tup{};
             bool success = false;
             try {
-                success = parse(read_ptr, tup_size, &tup);
+                if constexpr (sample_latency) {
+                    if (unlikely(--tuples_until_sample == 0)) {
+                        tuples_until_sample = sample_interval;
+                        const uint64_t start = tsc_begin();
+                        success = parse(read_ptr, tup_size, &tup);
+                        result->latency.record(tsc_end() - start);
+                    } else {
+                        success = parse(read_ptr, tup_size, &tup);
+                    }
+                } else {
+                    success = parse(read_ptr, tup_size, &tup);
+                }
             } catch (...) {
                 success = false;
             }
@@ -226,7 +761,7 @@ void parse_tuples(ThreadResult* result,
                 fmt::print("Invalid input tuple dropped\n");
                 exit(1);  // NOLINT(concurrency-mt-unsafe)
             }
-            DoNotOptimize(tup);
+            sink->store(i, tup);
 
             read_ptr += tup_size;
             ++tuple_index;
@@ -237,11 +772,512 @@ void parse_tuples(ThreadResult* result,
                 fmt::print("Thread read tuple {}\n", tup);
             }
         }
+        sink->flush();
 
         result->tuples_read += RUN_SIZE;
         result->bytes_read += total_bytes_read;
+        flush_fallback_tuples(result);
     }
 }
 
+// Like parse_tuples_into, but without looking at dataset.tuple_sizes: every run first scans for
+// the newlines ending the next tuples, then parses them. Parsers get each line including its '\n'.
+template <ParseFunc parse, typename Sink>
+void parse_framed_tuples_into(Sink* sink,
+                              ThreadResult* result,
+                              const DatasetView& dataset,
+                              const std::atomic<bool>& stop_flag) {
+    const std::byte* const start_ptr = dataset.memory.data();
+    const std::byte* const end_ptr = start_ptr + dataset.memory.size();
+    const std::byte* read_ptr = start_ptr;
+    std::vector<uint32_t> line_ends(RUN_SIZE);
+
+    while (!stop_flag.load(std::memory_order_relaxed)) {
+        size_t total_bytes_read = 0;
+        size_t run_tuples_read = 0;
+        uint64_t scan_cycles = 0;
+        uint64_t parse_cycles = 0;
+
+        while (run_tuples_read < RUN_SIZE) {
+            if (read_ptr == end_ptr) {
+                if constexpr (debug_output) {
+                    return;
+                }
+                read_ptr = start_ptr;
+            }
+
+            const uint64_t scan_start = tsc_begin();
+            const size_t line_count =
+                find_line_ends(read_ptr, end_ptr, RUN_SIZE - run_tuples_read, line_ends.data());
+            const uint64_t parse_start = tsc_begin();
+            if (unlikely(line_count == 0)) {
+                fmt::print("Framed input does not end with a newline\n");
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+
+            const std::byte* line_ptr = read_ptr;
+            for (size_t i = 0; i < line_count; ++i) {
+                const std::byte* const next_line_ptr = read_ptr + line_ends[i];
+                const auto tup_size = static_cast<tuple_size_t>(next_line_ptr - line_ptr);
+
+                NativeTuple tup{};
+                bool success = false;
+                try {
+                    success = parse(line_ptr, tup_size, &tup);
+                } catch (...) {
+                    success = false;
+                }
+                if (unlikely(!success)) {
+                    fmt::print("Invalid input tuple dropped\n");
+                    exit(1);  // NOLINT(concurrency-mt-unsafe)
+                }
+                sink->store(run_tuples_read + i, tup);
+
+                if constexpr (debug_output) {
+                    fmt::print("Thread read tuple {}\n", tup);
+                }
+                line_ptr = next_line_ptr;
+            }
+            const uint64_t parse_end = tsc_end();
+
+            scan_cycles += parse_start - scan_start;
+            parse_cycles += parse_end - parse_start;
+            total_bytes_read += static_cast<size_t>(line_ptr - read_ptr);
+            run_tuples_read += line_count;
+            read_ptr = line_ptr;
+        }
+        sink->flush();
+
+        result->tuples_read += RUN_SIZE;
+        result->bytes_read += total_bytes_read;
+        result->scan_cycles.fetch_add(scan_cycles, std::memory_order_relaxed);
+        result->parse_cycles.fetch_add(parse_cycles, std::memory_order_relaxed);
+        flush_fallback_tuples(result);
+    }
+}
+
+// Ingest modes: the dataset arrives over and over as one byte stream, so the tuple sizes still
+// tell where tuples end. Tuples are parsed straight from the receive buffers, only the ones that
+// straddle two receives are copied together first.
+template <ParseFunc parse, typename Sink>
+void parse_received_tuples_into(Sink* sink,
+                                ThreadResult* result,
+                                const DatasetView& dataset,
+                                IngestReceiver* receiver,
+                                const std::atomic<bool>& stop_flag) {
+    const auto tuple_sizes = dataset.tuple_sizes;
+    std::vector<std::byte> partial(
+        *std::max_element(tuple_sizes.begin(), tuple_sizes.end()) + MEMORY_PADDING);
+    size_t partial_size = 0;
+    size_t tuple_index = 0;
+    size_t run_tuples_read = 0;
+    size_t run_bytes_read = 0;
+
+    const auto parse_tuple = [&](const std::byte* read_ptr, tuple_size_t tup_size) {
+        NativeTuple tup{};
+        bool success = false;
+        try {
+            success = parse(read_ptr, tup_size, &tup);
+        } catch (...) {
+            success = false;
+        }
+        if (unlikely(!success)) {
+            fmt::print("Invalid input tuple dropped\n");
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        sink->store(run_tuples_read, tup);
+
+        if constexpr (debug_output) {
+            fmt::print("Thread read tuple {}\n", tup);
+        }
+
+        tuple_index = tuple_index + 1 == tuple_sizes.size() ? 0 : tuple_index + 1;
+        run_bytes_read += tup_size;
+        if (++run_tuples_read == RUN_SIZE) {
+            sink->flush();
+            result->tuples_read += run_tuples_read;
+            result->bytes_read += run_bytes_read;
+            flush_fallback_tuples(result);
+            run_tuples_read = 0;
+            run_bytes_read = 0;
+        }
+    };
+
+    receiver->run(stop_flag, [&](std::span<const std::byte> data) {
+        const std::byte* read_ptr = data.data();
+        const std::byte* const end_ptr = read_ptr + data.size();
+        if (partial_size != 0) {
+            const tuple_size_t tup_size = tuple_sizes[tuple_index];
+            const size_t count = std::min(tup_size - partial_size, data.size());
+            std::copy_n(read_ptr, count, partial.data() + partial_size);
+            partial_size += count;
+            read_ptr += count;
+            if (partial_size < tup_size) {
+                return;
+            }
+            parse_tuple(partial.data(), tup_size);
+            partial_size = 0;
+        }
+        while (static_cast<size_t>(end_ptr - read_ptr) >= tuple_sizes[tuple_index]) {
+            const tuple_size_t tup_size = tuple_sizes[tuple_index];
+            parse_tuple(read_ptr, tup_size);
+            read_ptr += tup_size;
+        }
+        partial_size = static_cast<size_t>(end_ptr - read_ptr);
+        std::copy(read_ptr, end_ptr, partial.data());
+    });
+}
+
+// --compress: every block is decompressed into a buffer of this thread before its tuples are
+// parsed, using the tuple sizes of the dataset the blocks were compressed from. Bytes read count
+// the decompressed tuples.
+template <ParseFunc parse, typename Sink>
+void parse_compressed_tuples_into(Sink* sink,
+                                  ThreadResult* result,
+                                  const DatasetView& dataset,
+                                  const CompressedDataset& compressed,
+                                  const std::atomic<bool>& stop_flag) {
+    std::vector<std::byte> block_buffer(compressed.max_block_raw_size + MEMORY_PADDING);
+    size_t block_index = 0;
+    size_t run_tuples_read = 0;
+    size_t run_bytes_read = 0;
+    uint64_t decompress_cycles = 0;
+
+    while (!stop_flag.load(std::memory_order_relaxed)) {
+        const CompressedBlock& block = compressed.blocks[block_index];
+        block_index = block_index + 1 == compressed.blocks.size() ? 0 : block_index + 1;
+
+        const uint64_t decompress_start = tsc_begin();
+        const bool decompressed = decompress_block(
+            compressed.codec, std::span(compressed.memory).subspan(block.offset, block.size),
+            std::span(block_buffer).first(block.raw_size));
+        decompress_cycles += tsc_end() - decompress_start;
+        if (unlikely(!decompressed)) {
+            fmt::print("Corrupt compressed block dropped\n");
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+
+        const std::byte* read_ptr = block_buffer.data();
+        for (size_t i = 0; i < block.tuple_count; ++i) {
+            const tuple_size_t tup_size = dataset.tuple_sizes[block.first_tuple + i];
+
+            NativeTuple tup{};
+            bool success = false;
+            try {
+                success = parse(read_ptr, tup_size, &tup);
+            } catch (...) {
+                success = false;
+            }
+            if (unlikely(!success)) {
+                fmt::print("Invalid input tuple dropped\n");
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+            sink->store(run_tuples_read, tup);
+
+            if constexpr (debug_output) {
+                fmt::print("Thread read tuple {}\n", tup);
+            }
+
+            read_ptr += tup_size;
+            run_bytes_read += tup_size;
+            if (++run_tuples_read == RUN_SIZE) {
+                sink->flush();
+                result->tuples_read += run_tuples_read;
+                result->bytes_read += run_bytes_read;
+                result->decompress_cycles.fetch_add(std::exchange(decompress_cycles, 0),
+                                                    std::memory_order_relaxed);
+                flush_fallback_tuples(result);
+                run_tuples_read = 0;
+                run_bytes_read = 0;
+            }
+        }
+    }
+}
+
+// Parser stage of pipeline mode. Throughput is counted by the consumer.
+template <ParseFunc parse>
+void parse_pipeline_chunks(PipelineLane* lane, const std::atomic<bool>& stop_flag) {
+    uint64_t wait_cycles = 0;
+    DatasetView chunk;
+    TupleBatch* batch = nullptr;
+    while (pop_or_wait(&lane->chunks, &chunk, &wait_cycles, stop_flag) &&
+           pop_or_wait(&lane->empty, &batch, &wait_cycles, stop_flag)) {
+        const std::byte* read_ptr = chunk.memory.data();
+        for (size_t i = 0; i < chunk.tuple_sizes.size(); ++i) {
+            const tuple_size_t tup_size = chunk.tuple_sizes[i];
+            bool success = false;
+            try {
+                success = parse(read_ptr, tup_size, &batch->tuples[i]);
+            } catch (...) {
+                success = false;
+            }
+            if (unlikely(!success)) {
+                fmt::print("Invalid input tuple dropped\n");
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+            read_ptr += tup_size;
+        }
+        batch->count = chunk.tuple_sizes.size();
+        batch->bytes = chunk.memory.size();
+        lane->filled.try_push(batch);
+        lane->parser_wait_cycles.fetch_add(std::exchange(wait_cycles, 0),
+                                           std::memory_order_relaxed);
+    }
+}
+
+template <ParseFunc parse>
+void parse_tuples(ThreadResult* result,
+                  const DatasetView& dataset,
+                  const ParseOptions& options,
+                  const std::atomic<bool>& stop_flag) {
+    if (options.pipeline_lane != nullptr) {
+        parse_pipeline_chunks<parse>(options.pipeline_lane, stop_flag);
+        return;
+    }
+
+    // Separate instantiations, so the loop without sampling has no trace of it.
+    with_output_sink(options, [&](auto* sink) {
+        if (options.receiver != nullptr) {
+            parse_received_tuples_into<parse>(sink, result, dataset, options.receiver, stop_flag);
+        } else if (options.compressed != nullptr) {
+            parse_compressed_tuples_into<parse>(sink, result, dataset, *options.compressed,
+                                                stop_flag);
+        } else if (options.framed) {
+            parse_framed_tuples_into<parse>(sink, result, dataset, stop_flag);
+        } else if (options.latency_sample_interval != 0) {
+            parse_tuples_into<parse, true>(sink, result, dataset, options.latency_sample_interval,
+                                           stop_flag);
+        } else {
+            parse_tuples_into<parse, false>(sink, result, dataset, 0, stop_flag);
+        }
+    });
+}
+
+// Batched parsers get a whole run of consecutive tuples at once and write every parsed tuple to
+// the output array. They may only report success if they found exactly `tuple_count` tuples.
+using BatchParseFunc =
+    bool (*)(const std::byte*, size_t, size_t, const ParseOptions&, NativeTuple*);
+template <BatchParseFunc parse, typename Sink>
+void parse_tuple_batches_into(Sink* sink,
+                              ThreadResult* result,
+                              const DatasetView& dataset,
+                              const ParseOptions& options,
+                              const std::atomic<bool>& stop_flag) {
+    const std::byte* const start_ptr = dataset.memory.data();
+    const std::byte* read_ptr = start_ptr;
+    size_t tuple_index = 0;
+    const size_t tuple_count = dataset.tuple_sizes.size();
+
+    // Unlike tuple-at-a-time parsers, batched parsers always pay for the stores into this buffer.
+    NativeTuple* const tups = sink->batch_output();
+
+    while (!stop_flag.load(std::memory_order_relaxed)) {
+        size_t total_bytes_read = 0;
+        size_t run_tuples_read = 0;
+
+        while (run_tuples_read < RUN_SIZE) {
+            if (tuple_index == tuple_count) {
+                if constexpr (debug_output) {
+                    return;
+                }
+                read_ptr = start_ptr;
+                tuple_index = 0;
+            }
+
+            // A batch never wraps around the end of the memory.
+            const size_t batch_tuple_count =
+                std::min(RUN_SIZE - run_tuples_read, tuple_count - tuple_index);
+            size_t batch_size = 0;
+            for (size_t i = 0; i < batch_tuple_count; ++i) {
+                batch_size += dataset.tuple_sizes[tuple_index + i];
+            }
+
+            bool success = false;
+            try {
+                success = parse(read_ptr, batch_size, batch_tuple_count, options,
+                                tups + run_tuples_read);
+            } catch (...) {
+                success = false;
+            }
+            if (unlikely(!success)) {
+                fmt::print("Invalid input tuple dropped\n");
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+            sink->store_batch(run_tuples_read, batch_tuple_count);
+
+            if constexpr (debug_output) {
+                for (size_t i = 0; i < batch_tuple_count; ++i) {
+                    fmt::print("Thread read tuple {}\n", tups[run_tuples_read + i]);
+                }
+            }
+
+            read_ptr += batch_size;
+            tuple_index += batch_tuple_count;
+            run_tuples_read += batch_tuple_count;
+            total_bytes_read += batch_size;
+        }
+        sink->flush();
+
+        result->tuples_read += run_tuples_read;
+        result->bytes_read += total_bytes_read;
+    }
+}
+
+template <BatchParseFunc parse>
+void parse_pipeline_chunk_batches(PipelineLane* lane,
+                                  const ParseOptions& options,
+                                  const std::atomic<bool>& stop_flag) {
+    uint64_t wait_cycles = 0;
+    DatasetView chunk;
+    TupleBatch* batch = nullptr;
+    while (pop_or_wait(&lane->chunks, &chunk, &wait_cycles, stop_flag) &&
+           pop_or_wait(&lane->empty, &batch, &wait_cycles, stop_flag)) {
+        bool success = false;
+        try {
+            success = parse(chunk.memory.data(), chunk.memory.size(), chunk.tuple_sizes.size(),
+                            options, batch->tuples.data());
+        } catch (...) {
+            success = false;
+        }
+        if (unlikely(!success)) {
+            fmt::print("Invalid input tuple dropped\n");
+            exit(1);  // NOLINT(concurrency-mt-unsafe)
+        }
+        batch->count = chunk.tuple_sizes.size();
+        batch->bytes = chunk.memory.size();
+        lane->filled.try_push(batch);
+        lane->parser_wait_cycles.fetch_add(std::exchange(wait_cycles, 0),
+                                           std::memory_order_relaxed);
+    }
+}
+
+template <BatchParseFunc parse>
+void parse_tuple_batches(ThreadResult* result,
+                         const DatasetView& dataset,
+                         const ParseOptions& options,
+                         const std::atomic<bool>& stop_flag) {
+    if (options.pipeline_lane != nullptr) {
+        parse_pipeline_chunk_batches<parse>(options.pipeline_lane, options, stop_flag);
+        return;
+    }
+
+    with_output_sink(options, [&](auto* sink) {
+        parse_tuple_batches_into<parse>(sink, result, dataset, options, stop_flag);
+    });
+}
+
+// Appends the serialized tuples[*tuple_index], ... to buf until it holds RUN_SIZE tuples, wrapping
+// around at the end of `tuples`. Stores the size of each tuple if tuple_sizes is given.
+template <auto serialize>
+void serialize_run(std::span<const NativeTuple> tuples,
+                   const CsvDialect& dialect,
+                   size_t* tuple_index,
+                   std::vector<std::byte>* buf,
+                   tuple_size_t* tuple_sizes) {
+    for (size_t i = 0; i < RUN_SIZE; ++i) {
+        const size_t old_size = buf->size();
+        serialize_tuple(serialize, tuples[*tuple_index], dialect, buf);
+        if (tuple_sizes != nullptr) {
+            tuple_sizes[i] = buf->size() - old_size;
+        }
+        *tuple_index = *tuple_index + 1 == tuples.size() ? 0 : *tuple_index + 1;
+    }
+}
+
+// Write path (--mode serialize): every thread serializes the same tuples over and over, one run at
+// a time into a buffer that keeps its capacity.
+template <auto serialize>
+void serialize_tuples(ThreadResult* result,
+                      std::span<const NativeTuple> tuples,
+                      const ParseOptions& options,
+                      const std::atomic<bool>& stop_flag) {
+    std::vector<std::byte> buf;
+    size_t tuple_index = 0;
+    while (!stop_flag.load(std::memory_order_relaxed)) {
+        buf.clear();
+        serialize_run<serialize>(tuples, options.csv_dialect, &tuple_index, &buf, nullptr);
+        DoNotOptimize(buf.data());
+
+        result->tuples_read += RUN_SIZE;
+        result->bytes_read += buf.size();
+    }
+}
+
+// --mode roundtrip: serializes a run like serialize_tuples, then parses it back into the sink.
+template <auto serialize, ParseFunc parse>
+void roundtrip_tuples(ThreadResult* result,
+                      std::span<const NativeTuple> tuples,
+                      const ParseOptions& options,
+                      const std::atomic<bool>& stop_flag) {
+    with_output_sink(options, [&](auto* sink) {
+        std::vector<std::byte> buf;
+        std::vector<tuple_size_t> tuple_sizes(RUN_SIZE);
+        size_t tuple_index = 0;
+        while (!stop_flag.load(std::memory_order_relaxed)) {
+            buf.clear();
+            serialize_run<serialize>(tuples, options.csv_dialect, &tuple_index, &buf,
+                                     tuple_sizes.data());
+            const size_t run_bytes = buf.size();
+            buf.resize(run_bytes + MEMORY_PADDING);
+
+            const std::byte* read_ptr = buf.data();
+            for (size_t i = 0; i < RUN_SIZE; ++i) {
+                NativeTuple tup{};
+                bool success = false;
+                try {
+                    success = parse(read_ptr, tuple_sizes[i], &tup);
+                } catch (...) {
+                    success = false;
+                }
+                if (unlikely(!success)) {
+                    fmt::print("Invalid input tuple dropped\n");
+                    exit(1);  // NOLINT(concurrency-mt-unsafe)
+                }
+                sink->store(i, tup);
+                read_ptr += tuple_sizes[i];
+            }
+            sink->flush();
+
+            result->tuples_read += RUN_SIZE;
+            result->bytes_read += run_bytes;
+            flush_fallback_tuples(result);
+        }
+    });
+}
+
+template <auto serialize, BatchParseFunc parse>
+void roundtrip_tuple_batches(ThreadResult* result,
+                             std::span<const NativeTuple> tuples,
+                             const ParseOptions& options,
+                             const std::atomic<bool>& stop_flag) {
+    with_output_sink(options, [&](auto* sink) {
+        std::vector<std::byte> buf;
+        size_t tuple_index = 0;
+        NativeTuple* const tups = sink->batch_output();
+        while (!stop_flag.load(std::memory_order_relaxed)) {
+            buf.clear();
+            serialize_run<serialize>(tuples, options.csv_dialect, &tuple_index, &buf, nullptr);
+            const size_t run_bytes = buf.size();
+            buf.resize(run_bytes + MEMORY_PADDING);
+
+            bool success = false;
+            try {
+                success = parse(buf.data(), run_bytes, RUN_SIZE, options, tups);
+            } catch (...) {
+                success = false;
+            }
+            if (unlikely(!success)) {
+                fmt::print("Invalid input tuple dropped\n");
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+            sink->store_batch(0, RUN_SIZE);
+            sink->flush();
+
+            result->tuples_read += RUN_SIZE;
+            result->bytes_read += run_bytes;
+        }
+    });
+}
+
 // NOLINTNEXTLINE(cppcoreguidelines-macro-usage)
 #define IMPL_VISIBILITY __attribute__((visibility("hidden")))
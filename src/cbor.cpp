@@ -0,0 +1,411 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+#include "bench.hpp"
+#include "cbor.hpp"
+
+using namespace std::literals::string_view_literals;
+
+namespace {
+
+// Keys of the map serialize_cbor writes, in this order.
+constexpr std::array<std::string_view, 7> cbor_keys{
+    "id"sv,         "timestamp"sv,   "load"sv,        "load_avg_1"sv,
+    "load_avg_5"sv, "load_avg_15"sv, "container_id"sv,
+};
+
+// Nesting of arrays, maps and tags CborReader::skip follows in unknown fields.
+constexpr size_t cbor_max_depth = 16;
+
+enum CborMajor : uint8_t {
+    major_uint = 0,
+    major_negative_int = 1,
+    major_bytes = 2,
+    major_text = 3,
+    major_array = 4,
+    major_map = 5,
+    major_tag = 6,
+    major_simple = 7,  // also floats
+};
+
+constexpr uint8_t cbor_indefinite = 31;
+constexpr std::byte cbor_break{0xff};
+
+std::byte* write_cbor_head(CborMajor major, uint64_t argument, std::byte* out) {
+    // the shortest encoding, as required by the deterministic encoding of RFC 8949
+    const auto initial = static_cast<uint8_t>(major << 5U);
+    if (argument < 24) {
+        out[0] = static_cast<std::byte>(initial | argument);
+        return out + 1;
+    }
+    if (argument <= UINT8_MAX) {
+        out[0] = static_cast<std::byte>(initial | 24U);
+        out[1] = static_cast<std::byte>(argument);
+        return out + 2;
+    }
+    if (argument <= UINT16_MAX) {
+        out[0] = static_cast<std::byte>(initial | 25U);
+        store_big_endian(static_cast<uint16_t>(argument), out + 1);
+        return out + 3;
+    }
+    if (argument <= UINT32_MAX) {
+        out[0] = static_cast<std::byte>(initial | 26U);
+        store_big_endian(static_cast<uint32_t>(argument), out + 1);
+        return out + 5;
+    }
+    out[0] = static_cast<std::byte>(initial | 27U);
+    store_big_endian(argument, out + 1);
+    return out + 9;
+}
+
+std::byte* write_cbor_key(std::string_view key, std::byte* out) {
+    out = write_cbor_head(major_text, key.size(), out);
+    std::memcpy(out, key.data(), key.size());
+    return out + key.size();
+}
+
+std::byte* write_cbor_float(float value, std::byte* out) {
+    out[0] = std::byte{0xfa};  // single precision, the width of NativeTuple's floats
+    store_big_endian(std::bit_cast<uint32_t>(value), out + 1);
+    return out + 5;
+}
+
+float half_to_float(uint16_t half) {
+    const uint32_t sign = (half & 0x8000U) << 16U;
+    const uint32_t exponent = (half >> 10U) & 0x1fU;
+    const uint32_t mantissa = half & 0x3ffU;
+    if (exponent == 0) {  // zero and subnormals
+        const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign != 0 ? -magnitude : magnitude;
+    }
+    if (exponent == 0x1f) {  // infinities and NaNs
+        return std::bit_cast<float>(sign | 0x7f800000U | (mantissa << 13U));
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23U) | (mantissa << 13U));
+}
+
+// Bounds-checked reads of CBOR data items, in any of their encodings. Tags are skipped.
+class CborReader {
+   public:
+    CborReader(const std::byte* ptr, const std::byte* end) : ptr_(ptr), end_(end) {}
+
+    [[nodiscard]] bool at_end() const { return ptr_ == end_; }
+
+    // True and consumed if the next byte is the break of an indefinite-length map or array.
+    [[nodiscard]] bool read_break() {
+        if (ptr_ == end_ || *ptr_ != cbor_break) {
+            return false;
+        }
+        ++ptr_;
+        return true;
+    }
+
+    // True and consumed if the next byte is `byte`.
+    [[nodiscard]] bool expect_byte(uint8_t byte) {
+        if (unlikely(ptr_ == end_ || *ptr_ != std::byte{byte})) {
+            return false;
+        }
+        ++ptr_;
+        return true;
+    }
+
+    // True and consumed if the next data item is `key` as a text string shorter than 24 bytes.
+    [[nodiscard]] bool expect_key(std::string_view key) {
+        if (unlikely(static_cast<size_t>(end_ - ptr_) < 1 + key.size() ||
+                     *ptr_ != static_cast<std::byte>((major_text << 5U) | key.size()) ||
+                     std::memcmp(ptr_ + 1, key.data(), key.size()) != 0)) {
+            return false;
+        }
+        ptr_ += 1 + key.size();
+        return true;
+    }
+
+    // Number of pairs, unknown for an indefinite-length map, which ends with a break.
+    [[nodiscard]] bool read_map_size(size_t* size, bool* indefinite) {
+        Head head;
+        if (unlikely(!read_head(&head) || head.major != major_map)) {
+            return false;
+        }
+        *indefinite = head.indefinite;
+        *size = head.argument;
+        return true;
+    }
+
+    // Indefinite-length strings are not accepted, there is no point in chunking short keys.
+    [[nodiscard]] bool read_text(std::string_view* str) {
+        Head head;
+        const std::byte* data = nullptr;
+        if (unlikely(!read_head(&head) || head.major != major_text || head.indefinite ||
+                     !read_bytes(head.argument, &data))) {
+            return false;
+        }
+        *str = std::string_view(reinterpret_cast<const char*>(data), head.argument);
+        return true;
+    }
+
+    [[nodiscard]] bool read_byte_string(std::span<const std::byte>* bytes) {
+        Head head;
+        const std::byte* data = nullptr;
+        if (unlikely(!read_head(&head) || head.major != major_bytes || head.indefinite ||
+                     !read_bytes(head.argument, &data))) {
+            return false;
+        }
+        *bytes = std::span(data, head.argument);
+        return true;
+    }
+
+    [[nodiscard]] bool read_uint(uint64_t* value) {
+        Head head;
+        if (unlikely(!read_head(&head) || head.major != major_uint)) {
+            return false;
+        }
+        *value = head.argument;
+        return true;
+    }
+
+    // Half, single or double precision.
+    [[nodiscard]] bool read_float(float* value) {
+        Head head;
+        if (unlikely(!read_head(&head) || head.major != major_simple)) {
+            return false;
+        }
+        switch (head.info) {
+            case 25:
+                *value = half_to_float(static_cast<uint16_t>(head.argument));
+                return true;
+            case 26:
+                *value = std::bit_cast<float>(static_cast<uint32_t>(head.argument));
+                return true;
+            case 27:
+                *value = static_cast<float>(std::bit_cast<double>(head.argument));
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Skips one data item of any type, e.g. of a field NativeTuple does not have.
+    [[nodiscard]] bool skip(size_t depth = 0) {
+        Head head;
+        if (unlikely(depth > cbor_max_depth || !read_head(&head))) {
+            return false;
+        }
+        switch (head.major) {
+            case major_uint:
+            case major_negative_int:
+                return true;
+            case major_bytes:
+            case major_text:
+                if (head.indefinite) {  // definite-length chunks until the break
+                    while (!read_break()) {
+                        Head chunk;
+                        if (unlikely(!read_head(&chunk) || chunk.major != head.major ||
+                                     chunk.indefinite || !skip_bytes(chunk.argument))) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                return skip_bytes(head.argument);
+            case major_array:
+            case major_map: {
+                const size_t items_per_entry = head.major == major_map ? 2 : 1;
+                if (head.indefinite) {
+                    while (!read_break()) {
+                        for (size_t i = 0; i < items_per_entry; ++i) {
+                            if (unlikely(!skip(depth + 1))) {
+                                return false;
+                            }
+                        }
+                    }
+                    return true;
+                }
+                // every item is at least one byte, malformed counts fail at the end of the input
+                for (uint64_t i = 0; i < head.argument; ++i) {
+                    for (size_t j = 0; j < items_per_entry; ++j) {
+                        if (unlikely(!skip(depth + 1))) {
+                            return false;
+                        }
+                    }
+                }
+                return true;
+            }
+            default:  // simple values and floats, their argument is all there is to them
+                return !head.indefinite;
+        }
+    }
+
+   private:
+    struct Head {
+        CborMajor major = major_simple;
+        uint8_t info = 0;  // additional information, the low 5 bits of the initial byte
+        uint64_t argument = 0;
+        bool indefinite = false;
+    };
+
+    bool read_head(Head* head) {
+        do {  // tags only annotate the item after them
+            if (unlikely(ptr_ == end_)) {
+                return false;
+            }
+            const auto initial = static_cast<uint8_t>(*ptr_++);
+            head->major = static_cast<CborMajor>(initial >> 5U);
+            head->info = initial & 0x1fU;
+            head->indefinite = false;
+
+            if (head->info < 24) {
+                head->argument = head->info;
+            } else if (head->info == cbor_indefinite) {
+                // only strings, arrays and maps have an indefinite length, 0xff is a stray break
+                if (unlikely(head->major < major_bytes || head->major > major_map)) {
+                    return false;
+                }
+                head->indefinite = true;
+                head->argument = 0;
+            } else if (unlikely(head->info > 27)) {  // reserved
+                return false;
+            } else {
+                const size_t size = size_t{1} << (head->info - 24U);
+                if (unlikely(static_cast<size_t>(end_ - ptr_) < size)) {
+                    return false;
+                }
+                switch (size) {
+                    case 1:
+                        head->argument = static_cast<uint8_t>(*ptr_);
+                        break;
+                    case 2:
+                        head->argument = load_big_endian<uint16_t>(ptr_);
+                        break;
+                    case 4:
+                        head->argument = load_big_endian<uint32_t>(ptr_);
+                        break;
+                    default:
+                        head->argument = load_big_endian<uint64_t>(ptr_);
+                        break;
+                }
+                ptr_ += size;
+            }
+        } while (head->major == major_tag);
+        return true;
+    }
+
+    bool read_bytes(uint64_t size, const std::byte** data) {
+        *data = ptr_;
+        return skip_bytes(size);
+    }
+
+    bool skip_bytes(uint64_t size) {
+        if (unlikely(static_cast<uint64_t>(end_ - ptr_) < size)) {
+            return false;
+        }
+        ptr_ += size;
+        return true;
+    }
+
+    const std::byte* ptr_;
+    const std::byte* end_;
+};
+
+}  // namespace
+
+IMPL_VISIBILITY void serialize_cbor(const NativeTuple& tup, std::vector<std::byte>* buf) {
+    // A map from field names to values, like the json formats.
+    constexpr size_t max_tuple_size = 160;
+    const size_t old_size = buf->size();
+    buf->resize(old_size + max_tuple_size);
+    std::byte* out = buf->data() + old_size;
+
+    out = write_cbor_head(major_map, cbor_keys.size(), out);
+    out = write_cbor_head(major_uint, tup.id, write_cbor_key(cbor_keys[0], out));
+    out = write_cbor_head(major_uint, tup.timestamp, write_cbor_key(cbor_keys[1], out));
+    out = write_cbor_float(tup.load, write_cbor_key(cbor_keys[2], out));
+    out = write_cbor_float(tup.load_avg_1, write_cbor_key(cbor_keys[3], out));
+    out = write_cbor_float(tup.load_avg_5, write_cbor_key(cbor_keys[4], out));
+    out = write_cbor_float(tup.load_avg_15, write_cbor_key(cbor_keys[5], out));
+    out = write_cbor_head(major_bytes, HASH_BYTES, write_cbor_key(cbor_keys[6], out));
+    out = std::copy(tup.container_id.begin(), tup.container_id.end(), out);
+
+    buf->resize(static_cast<size_t>(out - buf->data()));
+}
+
+IMPL_VISIBILITY bool parse_cbor(const std::byte* __restrict__ read_ptr,
+                                tuple_size_t tup_size,
+                                NativeTuple* tup) noexcept {
+    // Walks the map like a generic decoder: fields in any order and encoding, unknown ones skipped.
+    CborReader reader(read_ptr, read_ptr + tup_size);
+    size_t field_count = 0;
+    bool indefinite = false;
+    if (unlikely(!reader.read_map_size(&field_count, &indefinite))) {
+        return false;
+    }
+
+    uint32_t fields_seen = 0;  // bit i: cbor_keys[i]
+    for (size_t i = 0; indefinite ? !reader.read_break() : i < field_count; ++i) {
+        std::string_view key;
+        if (unlikely(!reader.read_text(&key))) {
+            return false;
+        }
+
+        bool success = false;
+        std::span<const std::byte> container_id;
+        // clang-format off
+        if (key == "id"sv) { success = reader.read_uint(&tup->id); fields_seen |= 1U << 0U;
+        } else if (key == "timestamp"sv) { success = reader.read_uint(&tup->timestamp); fields_seen |= 1U << 1U;
+        } else if (key == "load"sv) { success = reader.read_float(&tup->load); fields_seen |= 1U << 2U;
+        } else if (key == "load_avg_1"sv) { success = reader.read_float(&tup->load_avg_1); fields_seen |= 1U << 3U;
+        } else if (key == "load_avg_5"sv) { success = reader.read_float(&tup->load_avg_5); fields_seen |= 1U << 4U;
+        } else if (key == "load_avg_15"sv) { success = reader.read_float(&tup->load_avg_15); fields_seen |= 1U << 5U;
+        } else if (key == "container_id"sv) {
+            success = reader.read_byte_string(&container_id) && container_id.size() == HASH_BYTES;
+            if (likely(success)) { std::copy(container_id.begin(), container_id.end(), tup->container_id.begin()); }
+            fields_seen |= 1U << 6U;
+        } else { success = reader.skip(); }
+        // clang-format on
+        if (unlikely(!success)) {
+            return false;
+        }
+    }
+    return likely(fields_seen == (1U << cbor_keys.size()) - 1 && reader.at_end());
+}
+
+IMPL_VISIBILITY bool parse_cbor_fast(const std::byte* __restrict__ read_ptr,
+                                     tuple_size_t tup_size,
+                                     NativeTuple* tup) noexcept {
+    // Expects the map exactly like serialize_cbor writes it: definite length, the keys in this
+    // order, compared as a whole, and a byte string container id. Integer and float widths may
+    // vary. Anything else goes to parse_cbor.
+    CborReader reader(read_ptr, read_ptr + tup_size);
+    std::span<const std::byte> container_id;
+    // clang-format off
+    if (likely(reader.expect_byte((major_map << 5U) | cbor_keys.size()) &&
+               reader.expect_key(cbor_keys[0]) && reader.read_uint(&tup->id) &&
+               reader.expect_key(cbor_keys[1]) && reader.read_uint(&tup->timestamp) &&
+               reader.expect_key(cbor_keys[2]) && reader.read_float(&tup->load) &&
+               reader.expect_key(cbor_keys[3]) && reader.read_float(&tup->load_avg_1) &&
+               reader.expect_key(cbor_keys[4]) && reader.read_float(&tup->load_avg_5) &&
+               reader.expect_key(cbor_keys[5]) && reader.read_float(&tup->load_avg_15) &&
+               reader.expect_key(cbor_keys[6]) && reader.read_byte_string(&container_id) &&
+               container_id.size() == HASH_BYTES && reader.at_end())) {
+        std::copy(container_id.begin(), container_id.end(), tup->container_id.begin());
+        return true;
+    }
+    // clang-format on
+
+    ++thread_fallback_tuples;
+    return parse_cbor(read_ptr, tup_size, tup);
+}
+
+// clang-format off
+template void generate_tuples<serialize_cbor>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_tuples<parse_cbor>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_cbor_fast>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+template void serialize_tuples<serialize_cbor>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_cbor, parse_cbor>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_cbor, parse_cbor_fast>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "bench.hpp"
+
+// clang-format off
+IMPL_VISIBILITY void serialize_cbor(const NativeTuple& tup, std::vector<std::byte>* buf);
+IMPL_VISIBILITY bool parse_cbor(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
+IMPL_VISIBILITY bool parse_cbor_fast(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
+
+extern template void generate_tuples<serialize_cbor>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void parse_tuples<parse_cbor>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_cbor_fast>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+extern template void serialize_tuples<serialize_cbor>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_cbor, parse_cbor>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_cbor, parse_cbor_fast>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
@@ -0,0 +1,226 @@
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#include "bench.hpp"
+#include "columnar.hpp"
+
+namespace {
+
+// Offsets of the columns from the start of a batch.
+struct RecordBatchLayout {
+    explicit RecordBatchLayout(size_t tuple_count)
+        : id(sizeof(RecordBatchHeader)),
+          timestamp(id + tuple_count * sizeof(uint64_t)),
+          load(timestamp + tuple_count * sizeof(uint64_t)),
+          load_avg_1(load + tuple_count * sizeof(float)),
+          load_avg_5(load_avg_1 + tuple_count * sizeof(float)),
+          load_avg_15(load_avg_5 + tuple_count * sizeof(float)),
+          container_id(load_avg_15 + tuple_count * sizeof(float)) {}
+
+    size_t id;
+    size_t timestamp;
+    size_t load;
+    size_t load_avg_1;
+    size_t load_avg_5;
+    size_t load_avg_15;
+    size_t container_id;
+};
+
+template <typename T>
+T* column(std::byte* batch, size_t offset) {
+    return reinterpret_cast<T*>(batch + offset);
+}
+
+template <typename T>
+std::span<const T> column(const std::byte* batch, size_t offset, size_t tuple_count) {
+    return {reinterpret_cast<const T*>(batch + offset), tuple_count};
+}
+
+void write_record_batch(std::byte* batch,
+                        size_t first_tuple_index,
+                        size_t tuple_count,
+                        const GeneratorOptions& options) {
+    const RecordBatchHeader header{RECORD_BATCH_MAGIC, static_cast<uint32_t>(tuple_count)};
+    std::memcpy(batch, &header, sizeof(header));
+
+    const RecordBatchLayout layout(tuple_count);
+    for (size_t i = 0; i < tuple_count; ++i) {
+        const NativeTuple tup =
+            generate_native_tuple(options.seed, first_tuple_index + i, options.profile);
+        column<uint64_t>(batch, layout.id)[i] = tup.id;
+        column<uint64_t>(batch, layout.timestamp)[i] = tup.timestamp;
+        column<float>(batch, layout.load)[i] = tup.load;
+        column<float>(batch, layout.load_avg_1)[i] = tup.load_avg_1;
+        column<float>(batch, layout.load_avg_5)[i] = tup.load_avg_5;
+        column<float>(batch, layout.load_avg_15)[i] = tup.load_avg_15;
+        column<std::array<std::byte, HASH_BYTES>>(batch, layout.container_id)[i] =
+            tup.container_id;
+    }
+}
+
+// Copies the rows to the sink, flushing it whenever its RUN_SIZE rows are full. The discard sink
+// only gets the column spans: reading columnar data in place needs no copy.
+template <typename Sink>
+void store_columns(Sink* sink, const ColumnBatch& columns, size_t* sink_rows) {
+    if constexpr (std::is_same_v<Sink, DiscardSink>) {
+        DoNotOptimize(columns);
+        return;
+    }
+
+    for (size_t first = 0; first < columns.size();) {
+        const size_t count = std::min(columns.size() - first, RUN_SIZE - *sink_rows);
+        if constexpr (std::is_same_v<Sink, SoaSink>) {
+            const auto copy = [&](auto column, auto& sink_column) {
+                std::copy_n(column.begin() + static_cast<int64_t>(first), count,
+                            sink_column.begin() + static_cast<int64_t>(*sink_rows));
+            };
+            copy(columns.id, sink->id);
+            copy(columns.timestamp, sink->timestamp);
+            copy(columns.load, sink->load);
+            copy(columns.load_avg_1, sink->load_avg_1);
+            copy(columns.load_avg_5, sink->load_avg_5);
+            copy(columns.load_avg_15, sink->load_avg_15);
+            copy(columns.container_id, sink->container_id);
+        } else {
+            for (size_t i = 0; i < count; ++i) {
+                sink->store(*sink_rows + i, columns.row(first + i));
+            }
+        }
+
+        first += count;
+        *sink_rows += count;
+        if (*sink_rows == RUN_SIZE) {
+            sink->flush();
+            *sink_rows = 0;
+        }
+    }
+}
+
+template <typename Sink>
+void parse_record_batches_into(Sink* sink,
+                               ThreadResult* result,
+                               const DatasetView& dataset,
+                               const std::atomic<bool>& stop_flag) {
+    const std::byte* const start_ptr = dataset.memory.data();
+    size_t offset = 0;
+    size_t tuple_index = 0;
+    const size_t tuple_count = dataset.tuple_sizes.size();
+    size_t sink_rows = 0;
+
+    while (!stop_flag.load(std::memory_order_relaxed)) {
+        size_t total_bytes_read = 0;
+        size_t run_tuples_read = 0;
+
+        // Whole batches only, so a run may end up to one batch after RUN_SIZE tuples.
+        while (run_tuples_read < RUN_SIZE) {
+            if (tuple_index == tuple_count) {
+                if constexpr (debug_output) {
+                    return;
+                }
+                offset = 0;
+                tuple_index = 0;
+            }
+
+            ColumnBatch columns;
+            if (unlikely(!parse_record_batch(start_ptr + offset, dataset.memory.size() - offset,
+                                             &columns) ||
+                         columns.size() > tuple_count - tuple_index)) {
+                fmt::print("Invalid input tuple dropped\n");
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+            store_columns(sink, columns, &sink_rows);
+
+            if constexpr (debug_output) {
+                for (size_t i = 0; i < columns.size(); ++i) {
+                    fmt::print("Thread read tuple {}\n", columns.row(i));
+                }
+            }
+
+            const size_t batch_size = record_batch_size(columns.size());
+            offset += batch_size;
+            tuple_index += columns.size();
+            run_tuples_read += columns.size();
+            total_bytes_read += batch_size;
+        }
+
+        result->tuples_read += run_tuples_read;
+        result->bytes_read += total_bytes_read;
+    }
+}
+
+}  // namespace
+
+IMPL_VISIBILITY void generate_record_batches(std::vector<std::byte>* memory,
+                                             size_t target_memory_size,
+                                             std::vector<tuple_size_t>* tuple_sizes,
+                                             const GeneratorOptions& options) {
+    // Whole batches that fit into the target size, like generate_dataset, but at least one.
+    const size_t batch_tuples = options.record_batch_tuples;
+    const size_t batch_size = record_batch_size(batch_tuples);
+    const size_t batch_count = std::max<size_t>(1, target_memory_size / batch_size);
+
+    memory->resize(batch_count * batch_size);
+    tuple_sizes->assign(batch_count * batch_tuples, sizeof(NativeTuple));
+    for (size_t batch = 0; batch < batch_count; ++batch) {
+        (*tuple_sizes)[batch * batch_tuples] += sizeof(RecordBatchHeader);
+    }
+
+    std::atomic<size_t> next_batch = 0;
+    std::vector<std::thread> threads;
+    threads.reserve(options.thread_count);
+    for (size_t thread = 0; thread < options.thread_count; ++thread) {
+        threads.emplace_back([&, thread] {
+            if (!options.cpus.empty()) {
+                pin_current_thread_to_cpu(options.cpus[thread % options.cpus.size()]);
+            }
+            for (size_t batch = next_batch.fetch_add(1); batch < batch_count;
+                 batch = next_batch.fetch_add(1)) {
+                write_record_batch(memory->data() + batch * batch_size, batch * batch_tuples,
+                                   batch_tuples, options);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+IMPL_VISIBILITY bool parse_record_batch(const std::byte* __restrict__ read_ptr,
+                                        size_t available,
+                                        ColumnBatch* columns) noexcept {
+    // The columns are read in place, so they have to be aligned.
+    RecordBatchHeader header{};
+    if (unlikely(available < sizeof(header) ||
+                 reinterpret_cast<uintptr_t>(read_ptr) % alignof(uint64_t) != 0)) {
+        return false;
+    }
+    std::memcpy(&header, read_ptr, sizeof(header));
+    if (unlikely(header.magic != RECORD_BATCH_MAGIC || header.tuple_count == 0 ||
+                 record_batch_size(header.tuple_count) > available)) {
+        return false;
+    }
+
+    const size_t count = header.tuple_count;
+    const RecordBatchLayout layout(count);
+    columns->id = column<uint64_t>(read_ptr, layout.id, count);
+    columns->timestamp = column<uint64_t>(read_ptr, layout.timestamp, count);
+    columns->load = column<float>(read_ptr, layout.load, count);
+    columns->load_avg_1 = column<float>(read_ptr, layout.load_avg_1, count);
+    columns->load_avg_5 = column<float>(read_ptr, layout.load_avg_5, count);
+    columns->load_avg_15 = column<float>(read_ptr, layout.load_avg_15, count);
+    columns->container_id =
+        column<std::array<std::byte, HASH_BYTES>>(read_ptr, layout.container_id, count);
+    return true;
+}
+
+IMPL_VISIBILITY void parse_record_batches(ThreadResult* result,
+                                          const DatasetView& dataset,
+                                          const ParseOptions& options,
+                                          const std::atomic<bool>& stop_flag) {
+    with_output_sink(options, [&](auto* sink) {
+        parse_record_batches_into(sink, result, dataset, stop_flag);
+    });
+}
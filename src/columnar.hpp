@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "bench.hpp"
+
+// Columnar record batches, laid out like an Arrow record batch of non-nullable columns: a header,
+// then the id column, the timestamp column, the four float columns and the fixed-size binary
+// container id column, each holding one value per tuple of the batch. The tuples of the dataset
+// are the rows of its batches; the first row of every batch also accounts for the header in the
+// tuple sizes, so they still add up to the memory size.
+//
+// The parser validates a header once per batch and hands out the columns in place, which is all
+// a columnar reader has to do. Only the aos and soa sinks copy them.
+
+constexpr uint32_t RECORD_BATCH_MAGIC = 0x48435242;  // "BRCH"
+
+struct RecordBatchHeader {
+    uint32_t magic;
+    uint32_t tuple_count;
+};
+
+// Every column starts 8-byte aligned: the header and the 8-byte columns come first.
+static_assert(sizeof(RecordBatchHeader) % alignof(uint64_t) == 0);
+
+// Bytes of one batch of tuple_count tuples, all columns together take sizeof(NativeTuple) per row.
+static_assert(sizeof(NativeTuple) == 2 * sizeof(uint64_t) + 4 * sizeof(float) + HASH_BYTES);
+constexpr size_t record_batch_size(size_t tuple_count) {
+    return sizeof(RecordBatchHeader) + tuple_count * sizeof(NativeTuple);
+}
+
+// Columns of one batch, pointing into the dataset.
+struct ColumnBatch {
+    std::span<const uint64_t> id;
+    std::span<const uint64_t> timestamp;
+    std::span<const float> load;
+    std::span<const float> load_avg_1;
+    std::span<const float> load_avg_5;
+    std::span<const float> load_avg_15;
+    std::span<const std::array<std::byte, HASH_BYTES>> container_id;
+
+    [[nodiscard]] size_t size() const { return id.size(); }
+    [[nodiscard]] NativeTuple row(size_t index) const {
+        return {id[index],         timestamp[index],   load[index],        load_avg_1[index],
+                load_avg_5[index], load_avg_15[index], container_id[index]};
+    }
+};
+
+// clang-format off
+// Writes batches of options.record_batch_tuples tuples, the parser reads the counts from the headers.
+IMPL_VISIBILITY void generate_record_batches(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+
+// Validates the header of the batch at read_ptr, which may take up to `available` bytes, and
+// points columns into it.
+IMPL_VISIBILITY bool parse_record_batch(const std::byte* __restrict__ read_ptr, size_t available, ColumnBatch* columns) noexcept;
+
+// Only supports plain parse runs over the whole dataset: without --pipeline, --framing,
+// --latency-sample, --ingest, --compress or --numa partition, which all cut it between any tuples.
+IMPL_VISIBILITY void parse_record_batches(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+// clang-format on
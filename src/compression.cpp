@@ -0,0 +1,90 @@
+#include <fmt/format.h>
+#include <lz4.h>
+#include <lz4hc.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include "compression.hpp"
+
+void compress_block(Codec codec,
+                    int level,
+                    std::span<const std::byte> src,
+                    std::vector<std::byte>* dst) {
+    const size_t old_size = dst->size();
+    switch (codec) {
+        case Codec::none:
+            dst->insert(dst->end(), src.begin(), src.end());
+            return;
+        case Codec::lz4: {
+            if (src.size() > LZ4_MAX_INPUT_SIZE) {
+                throw std::runtime_error(
+                    fmt::format("lz4: block of {} B is too large to compress", src.size()));
+            }
+            const int src_size = static_cast<int>(src.size());
+            const int bound = LZ4_compressBound(src_size);
+            dst->resize(old_size + static_cast<size_t>(bound));
+            const auto* const src_ptr = reinterpret_cast<const char*>(src.data());
+            auto* const dst_ptr = reinterpret_cast<char*>(dst->data() + old_size);
+            const int size = level > 0
+                                 ? LZ4_compress_HC(src_ptr, dst_ptr, src_size, bound, level)
+                                 : LZ4_compress_default(src_ptr, dst_ptr, src_size, bound);
+            if (size <= 0) {
+                throw std::runtime_error("lz4: compression failed");
+            }
+            dst->resize(old_size + static_cast<size_t>(size));
+            return;
+        }
+        case Codec::zstd: {
+            const size_t bound = ZSTD_compressBound(src.size());
+            dst->resize(old_size + bound);
+            const size_t size =
+                ZSTD_compress(dst->data() + old_size, bound, src.data(), src.size(),
+                              level == 0 ? ZSTD_CLEVEL_DEFAULT : level);
+            if (ZSTD_isError(size) != 0U) {
+                throw std::runtime_error(
+                    fmt::format("zstd: compression failed: {}", ZSTD_getErrorName(size)));
+            }
+            dst->resize(old_size + size);
+            return;
+        }
+    }
+}
+
+bool decompress_block(Codec codec,
+                      std::span<const std::byte> src,
+                      std::span<std::byte> dst) noexcept {
+    switch (codec) {
+        case Codec::none:
+            if (src.size() != dst.size()) {
+                return false;
+            }
+            std::copy(src.begin(), src.end(), dst.begin());
+            return true;
+        case Codec::lz4:
+            if (src.size() > std::numeric_limits<int>::max() ||
+                dst.size() > std::numeric_limits<int>::max()) {
+                return false;
+            }
+            return LZ4_decompress_safe(reinterpret_cast<const char*>(src.data()),
+                                       reinterpret_cast<char*>(dst.data()),
+                                       static_cast<int>(src.size()),
+                                       static_cast<int>(dst.size())) ==
+                   static_cast<int>(dst.size());
+        case Codec::zstd: {
+            // one context per parser thread, ZSTD_decompress would create one per call
+            static thread_local const std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(
+                ZSTD_createDCtx(), ZSTD_freeDCtx);
+            if (context == nullptr) {
+                return false;
+            }
+            const size_t size = ZSTD_decompressDCtx(context.get(), dst.data(), dst.size(),
+                                                    src.data(), src.size());
+            return ZSTD_isError(size) == 0U && size == dst.size();
+        }
+    }
+    return false;
+}
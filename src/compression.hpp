@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// Block compression in front of every format (--compress): the dataset is cut into blocks of
+// whole tuples, every block is compressed on its own, and parser threads decompress one block at a
+// time into a buffer of their own before parsing its tuples.
+
+enum class Codec {
+    none,
+    lz4,   // LZ4 block format, LZ4_compress_HC for levels > 0
+    zstd,  // one zstd frame per block
+};
+
+struct CompressedBlock {
+    size_t offset;  // into CompressedDataset::memory
+    size_t size;
+    size_t raw_size;
+    size_t first_tuple;
+    size_t tuple_count;
+};
+
+struct CompressedDataset {
+    Codec codec = Codec::none;
+    std::vector<std::byte> memory;  // the compressed blocks back to back
+    std::vector<CompressedBlock> blocks;
+    size_t raw_size = 0;
+    size_t max_block_raw_size = 0;
+};
+
+// Appends the compressed `src` to dst. Level 0 is the default of the codec. Throws
+// std::runtime_error if the codec fails.
+void compress_block(Codec codec,
+                    int level,
+                    std::span<const std::byte> src,
+                    std::vector<std::byte>* dst);
+
+// Decompresses `src` into dst. False unless it decompresses to exactly dst.size() bytes.
+[[nodiscard]] bool decompress_block(Codec codec,
+                                    std::span<const std::byte> src,
+                                    std::span<std::byte> dst) noexcept;
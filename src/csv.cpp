@@ -4,18 +4,38 @@
 #include <fmt/format.h>
 #include <algorithm>
 #include <cstdint>
+#include <string_view>
+#include <type_traits>
 
 #include "bench.hpp"
 #include "csv.hpp"
+#include "csv_simd.hpp"
+#include "schema.hpp"
 
 IMPL_VISIBILITY void serialize_csv(const NativeTuple& tup, std::vector<std::byte>* buf) {
     thread_local auto local_buffer = fmt::memory_buffer();
     local_buffer.clear();
 
     fmt::format_to(std::back_inserter(local_buffer),
-                   FMT_COMPILE("{},{},{:f},{:f},{:f},{:f},{:02x}\0"), tup.id, tup.timestamp,
-                   tup.load, tup.load_avg_1, tup.load_avg_5, tup.load_avg_15,
-                   fmt::join(tup.container_id, ""));
+                   FMT_COMPILE("{},{},{},{},{},{},{:02x}\0"), tup.id, tup.timestamp,
+                   TextFloat{tup.load}, TextFloat{tup.load_avg_1}, TextFloat{tup.load_avg_5},
+                   TextFloat{tup.load_avg_15}, fmt::join(tup.container_id, ""));
+
+    const auto old_size = buf->size();
+    buf->resize(old_size + local_buffer.size());
+    std::copy(begin(local_buffer), end(local_buffer),
+              reinterpret_cast<char*>(buf->data() + old_size));
+}
+
+IMPL_VISIBILITY void serialize_csv_line(const NativeTuple& tup, std::vector<std::byte>* buf) {
+    // Same fields as serialize_csv, but terminated by a newline: the memory is one CSV file.
+    thread_local auto local_buffer = fmt::memory_buffer();
+    local_buffer.clear();
+
+    fmt::format_to(std::back_inserter(local_buffer),
+                   FMT_COMPILE("{},{},{},{},{},{},{:02x}\n"), tup.id, tup.timestamp,
+                   TextFloat{tup.load}, TextFloat{tup.load_avg_1}, TextFloat{tup.load_avg_5},
+                   TextFloat{tup.load_avg_15}, fmt::join(tup.container_id, ""));
 
     const auto old_size = buf->size();
     buf->resize(old_size + local_buffer.size());
@@ -61,7 +81,8 @@ IMPL_VISIBILITY bool parse_csv_std(const std::byte* __restrict__ read_ptr,
     }
 
     result = tup->set_container_id_from_hex_string(result.ptr + 1, str_end);
-    return likely(result.ec == std::errc() && result.ptr == str_end - 1 && *result.ptr == '\0');
+    return likely(result.ec == std::errc() && result.ptr == str_end - 1 &&
+                  (*result.ptr == '\0' || *result.ptr == '\n'));
 
 #else
 #warning "std::from_chars for float not supported. parser 'csvstd' will do nothing!"
@@ -110,7 +131,8 @@ IMPL_VISIBILITY bool parse_csv_fast_float(const std::byte* __restrict__ read_ptr
     }
 
     result = tup->set_container_id_from_hex_string(ff_result.ptr + 1, str_end);
-    return likely(result.ec == std::errc() && result.ptr == str_end - 1 && *result.ptr == '\0');
+    return likely(result.ec == std::errc() && result.ptr == str_end - 1 &&
+                  (*result.ptr == '\0' || *result.ptr == '\n'));
 }
 
 IMPL_VISIBILITY bool parse_csv_fast_float_custom(const std::byte* __restrict__ read_ptr,
@@ -154,7 +176,8 @@ IMPL_VISIBILITY bool parse_csv_fast_float_custom(const std::byte* __restrict__ r
     }
 
     result = tup->set_container_id_from_hex_string(ff_result.ptr + 1, str_end);
-    return likely(result.ec == std::errc() && result.ptr == str_end - 1 && *result.ptr == '\0');
+    return likely(result.ec == std::errc() && result.ptr == str_end - 1 &&
+                  (*result.ptr == '\0' || *result.ptr == '\n'));
 }
 
 IMPL_VISIBILITY bool parse_csv_benstrasser(const std::byte* __restrict__ read_ptr,
@@ -175,9 +198,214 @@ IMPL_VISIBILITY bool parse_csv_benstrasser(const std::byte* __restrict__ read_pt
     return likely(result.ec == std::errc() && result.ptr == container_id_end);
 }
 
+IMPL_VISIBILITY void serialize_csv_dialect(const NativeTuple& tup,
+                                           const CsvDialect& dialect,
+                                           std::vector<std::byte>* buf) {
+    // serialize_csv_line in the given dialect: for the default dialect, the same bytes.
+    thread_local auto local_buffer = fmt::memory_buffer();
+    local_buffer.clear();
+
+    const std::string_view quote(&dialect.quote, 1);
+    const std::string_view number_quote = dialect.quoting == CsvQuoting::all ? quote : "";
+    const std::string_view text_quote = dialect.quoting != CsvQuoting::none ? quote : "";
+    const std::string_view delimiter(&dialect.delimiter, 1);
+
+    auto out = std::back_inserter(local_buffer);
+    const auto write_number = [&](const auto& value) {
+        out = fmt::format_to(out, FMT_COMPILE("{}{}{}{}"), number_quote, value, number_quote,
+                             delimiter);
+    };
+    write_number(tup.id);
+    write_number(tup.timestamp);
+    write_number(TextFloat{tup.load});
+    write_number(TextFloat{tup.load_avg_1});
+    write_number(TextFloat{tup.load_avg_5});
+    write_number(TextFloat{tup.load_avg_15});
+    fmt::format_to(out, FMT_COMPILE("{}{:02x}{}\n"), text_quote, fmt::join(tup.container_id, ""),
+                   text_quote);
+
+    const auto old_size = buf->size();
+    buf->resize(old_size + local_buffer.size());
+    std::copy(begin(local_buffer), end(local_buffer),
+              reinterpret_cast<char*>(buf->data() + old_size));
+}
+
+IMPL_VISIBILITY bool parse_csv_simd(const std::byte* __restrict__ read_ptr,
+                                    size_t batch_size,
+                                    size_t tuple_count,
+                                    const ParseOptions& options,
+                                    NativeTuple* tups) noexcept {
+    constexpr size_t fields_per_tuple = 7;
+    const auto* const str = reinterpret_cast<const char*>(read_ptr);
+    const CsvDialect dialect = options.csv_dialect;
+
+    // Stage 1: where all fields of the batch end.
+    static thread_local std::vector<uint32_t> field_ends;
+    if (field_ends.size() < batch_size) {
+        field_ends.resize(batch_size);
+    }
+    size_t field_count = 0;
+    if (unlikely(batch_size > UINT32_MAX ||
+                 !kernels.index_csv_structurals(str, batch_size, dialect.delimiter,
+                                                dialect.quote, field_ends.data(), &field_count) ||
+                 field_count != tuple_count * fields_per_tuple)) {
+        return false;
+    }
+
+    // Stage 2: decode the fields between them. Only the last field of a tuple ends with a newline.
+    const uint32_t* field_end = field_ends.data();
+    size_t field_start = 0;
+    const char* value = nullptr;
+    size_t value_size = 0;
+    const auto next_field = [&](char end_char) -> bool {
+        size_t begin = field_start;
+        size_t end = *field_end++;
+        field_start = end + 1;
+        if (unlikely(str[end] != end_char)) {
+            return false;
+        }
+        if (end_char == '\n' && end != begin && str[end - 1] == '\r') {
+            --end;
+        }
+        if (str[begin] == dialect.quote) {
+            // Escaped quotes ("") never form a valid number or hex string, the kernels reject them.
+            if (unlikely(end - begin < 2 || str[end - 1] != dialect.quote)) {
+                return false;
+            }
+            ++begin;
+            --end;
+        }
+        value = str + begin;
+        value_size = end - begin;
+        return true;
+    };
+    const auto next_float = [&](float* result) -> bool {
+        if (unlikely(!next_field(dialect.delimiter))) {
+            return false;
+        }
+        const auto ff_result = fast_float::from_chars(value, value + value_size, *result);
+        return likely(ff_result.ec == std::errc() && ff_result.ptr == value + value_size);
+    };
+
+    for (size_t i = 0; i < tuple_count; ++i) {
+        NativeTuple* const tup = tups + i;
+        // clang-format off
+        if (unlikely(!next_field(dialect.delimiter) || !kernels.parse_uint_digits(value, value_size, &tup->id))) { return false; }
+        if (unlikely(!next_field(dialect.delimiter) || !kernels.parse_uint_digits(value, value_size, &tup->timestamp))) { return false; }
+        if (unlikely(!next_float(&tup->load) || !next_float(&tup->load_avg_1) ||
+                     !next_float(&tup->load_avg_5) || !next_float(&tup->load_avg_15))) { return false; }
+        if (unlikely(!next_field('\n') || value_size != 2 * HASH_BYTES ||
+                     !kernels.decode_hex(value, HASH_BYTES, tup->container_id.data()))) { return false; }
+        // clang-format on
+    }
+    return likely(field_start == batch_size);
+}
+
+template <typename Schema>
+IMPL_VISIBILITY void serialize_csv_schema(const typename Schema::Tuple& tup,
+                                          std::vector<std::byte>* buf) {
+    // For NativeTupleSchema, the same bytes as serialize_csv.
+    thread_local auto local_buffer = fmt::memory_buffer();
+    local_buffer.clear();
+
+    auto out = std::back_inserter(local_buffer);
+    Schema::for_each_field([&](auto field, size_t index) {
+        if (index != 0) {
+            local_buffer.push_back(',');
+        }
+        out = format_schema_value(out, decltype(field)::get(tup));
+    });
+    local_buffer.push_back('\0');
+
+    const auto old_size = buf->size();
+    buf->resize(old_size + local_buffer.size());
+    std::copy(begin(local_buffer), end(local_buffer),
+              reinterpret_cast<char*>(buf->data() + old_size));
+}
+
+// Parses the csv value at str, which ends at the next ',' -- or at value_end for the last field.
+template <typename T>
+std::from_chars_result parse_csv_value(const char* str,
+                                       const char* str_end,
+                                       const char* value_end,
+                                       T* value) {
+    if constexpr (std::is_same_v<T, uint64_t>) {
+        return parse_uint_str(str, str_end, *value);
+    } else if constexpr (std::is_same_v<T, float>) {
+        const auto result = fast_float::from_chars(str, str_end, *value);
+        return {result.ptr, result.ec};
+    } else if constexpr (is_inline_string<T>::value) {
+        if (value_end == nullptr) {
+            value_end = std::find(str, str_end, ',');
+        }
+        if (unlikely(!value->assign({str, static_cast<size_t>(value_end - str)}))) {
+            return {nullptr, std::errc::value_too_large};
+        }
+        return {value_end, std::errc()};
+    } else {
+        return parse_hex_bytes(str, str_end, value);
+    }
+}
+
+template <typename Schema>
+IMPL_VISIBILITY bool parse_csv_schema(const std::byte* __restrict__ read_ptr,
+                                      tuple_size_t tup_size,
+                                      typename Schema::Tuple* tup) noexcept {
+    const auto* str_ptr = reinterpret_cast<const char*>(read_ptr);
+    const auto* const str_end = str_ptr + tup_size;
+
+    // Like parse_csv_fast_float_custom: every field but the last ends with ',', the last one is
+    // followed by the terminating '\0' or, framed, '\n'.
+    return Schema::all_fields([&](auto field, size_t index) -> bool {
+        const bool last = index + 1 == Schema::field_count;
+        const auto result = parse_csv_value(str_ptr, str_end, last ? str_end - 1 : nullptr,
+                                            &decltype(field)::get(*tup));
+        if (unlikely(result.ec != std::errc())) {
+            return false;
+        }
+        if (last) {
+            return likely(result.ptr == str_end - 1 &&
+                          (*result.ptr == '\0' || *result.ptr == '\n'));
+        }
+        if (unlikely(result.ptr >= str_end - 1 || *result.ptr != ',')) {
+            return false;
+        }
+        str_ptr = result.ptr + 1;
+        return true;
+    });
+}
+
 // clang-format off
-template void generate_tuples<serialize_csv>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, std::mutex* mutex);
-template void parse_tuples<parse_csv_fast_float>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-template void parse_tuples<parse_csv_fast_float_custom>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-template void parse_tuples<parse_csv_std>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-template void parse_tuples<parse_csv_benstrasser>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
+template void generate_tuples<serialize_csv>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void generate_tuples<serialize_csv_line>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_tuples<parse_csv_fast_float>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_csv_fast_float_custom>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_csv_std>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_csv_benstrasser>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+template void generate_tuples<serialize_csv_dialect>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_tuple_batches<parse_csv_simd>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void serialize_tuples<serialize_csv_dialect>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuple_batches<serialize_csv_dialect, parse_csv_simd>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+template void serialize_tuples<serialize_csv>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_csv, parse_csv_fast_float>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_csv, parse_csv_fast_float_custom>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_csv, parse_csv_std>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_csv, parse_csv_benstrasser>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+template void serialize_csv_schema<NativeTupleSchema>(const NativeTuple& tup, std::vector<std::byte>* buf);
+template void serialize_csv_schema<WideTupleSchema>(const WideTuple& tup, std::vector<std::byte>* buf);
+template void serialize_csv_schema<StringTupleSchema>(const StringTuple& tup, std::vector<std::byte>* buf);
+template bool parse_csv_schema<NativeTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
+template bool parse_csv_schema<WideTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, WideTuple* tup) noexcept;
+template bool parse_csv_schema<StringTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, StringTuple* tup) noexcept;
+
+template void generate_tuples<serialize_csv_schema<NativeTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_tuples<parse_csv_schema<NativeTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void serialize_tuples<serialize_csv_schema<NativeTupleSchema>>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_csv_schema<NativeTupleSchema>, parse_csv_schema<NativeTupleSchema>>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void generate_schema_tuples<WideTupleSchema, serialize_csv_schema<WideTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_schema_tuples<WideTupleSchema, parse_csv_schema<WideTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void generate_schema_tuples<StringTupleSchema, serialize_csv_schema<StringTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_schema_tuples<StringTupleSchema, parse_csv_schema<StringTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
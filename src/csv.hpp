@@ -3,16 +3,53 @@
 #include <cstddef>
 #include <vector>
 #include "bench.hpp"
+#include "schema.hpp"
 
 // clang-format off
 IMPL_VISIBILITY void serialize_csv(const NativeTuple& tup, std::vector<std::byte>* buf);
+IMPL_VISIBILITY void serialize_csv_line(const NativeTuple& tup, std::vector<std::byte>* buf);
 IMPL_VISIBILITY bool parse_csv_fast_float(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
 IMPL_VISIBILITY bool parse_csv_fast_float_custom(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
 IMPL_VISIBILITY bool parse_csv_std(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
 IMPL_VISIBILITY bool parse_csv_benstrasser(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
 
-extern template void generate_tuples<serialize_csv>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, std::mutex* mutex);
-extern template void parse_tuples<parse_csv_fast_float>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-extern template void parse_tuples<parse_csv_fast_float_custom>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-extern template void parse_tuples<parse_csv_std>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-extern template void parse_tuples<parse_csv_benstrasser>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
+// csv-lines format in the dialect of GeneratorOptions / ParseOptions, see csv_simd.hpp
+IMPL_VISIBILITY void serialize_csv_dialect(const NativeTuple& tup, const CsvDialect& dialect, std::vector<std::byte>* buf);
+IMPL_VISIBILITY bool parse_csv_simd(const std::byte* __restrict__ read_ptr, size_t batch_size, size_t tuple_count, const ParseOptions& options, NativeTuple* tups) noexcept;
+
+extern template void generate_tuples<serialize_csv>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void generate_tuples<serialize_csv_line>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void parse_tuples<parse_csv_fast_float>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_csv_fast_float_custom>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_csv_std>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_csv_benstrasser>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+extern template void generate_tuples<serialize_csv_dialect>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void parse_tuple_batches<parse_csv_simd>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void serialize_tuples<serialize_csv_dialect>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuple_batches<serialize_csv_dialect, parse_csv_simd>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+extern template void serialize_tuples<serialize_csv>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_csv, parse_csv_fast_float>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_csv, parse_csv_fast_float_custom>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_csv, parse_csv_std>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_csv, parse_csv_benstrasser>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+// Serializer and parser of any schema, see schema.hpp.
+template <typename Schema> IMPL_VISIBILITY void serialize_csv_schema(const typename Schema::Tuple& tup, std::vector<std::byte>* buf);
+template <typename Schema> IMPL_VISIBILITY bool parse_csv_schema(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, typename Schema::Tuple* tup) noexcept;
+extern template void serialize_csv_schema<NativeTupleSchema>(const NativeTuple& tup, std::vector<std::byte>* buf);
+extern template void serialize_csv_schema<WideTupleSchema>(const WideTuple& tup, std::vector<std::byte>* buf);
+extern template void serialize_csv_schema<StringTupleSchema>(const StringTuple& tup, std::vector<std::byte>* buf);
+extern template bool parse_csv_schema<NativeTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
+extern template bool parse_csv_schema<WideTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, WideTuple* tup) noexcept;
+extern template bool parse_csv_schema<StringTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, StringTuple* tup) noexcept;
+
+extern template void generate_tuples<serialize_csv_schema<NativeTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void parse_tuples<parse_csv_schema<NativeTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void serialize_tuples<serialize_csv_schema<NativeTupleSchema>>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_csv_schema<NativeTupleSchema>, parse_csv_schema<NativeTupleSchema>>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void generate_schema_tuples<WideTupleSchema, serialize_csv_schema<WideTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void parse_schema_tuples<WideTupleSchema, parse_csv_schema<WideTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void generate_schema_tuples<StringTupleSchema, serialize_csv_schema<StringTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void parse_schema_tuples<StringTupleSchema, parse_csv_schema<StringTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
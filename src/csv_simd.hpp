@@ -0,0 +1,17 @@
+#pragma once
+
+// CSV dialect of the csv-lines format. Its SIMD parser (csvsimd) builds a structural index of all
+// delimiters and newlines outside quotes for a whole run of tuples first, then decodes every field
+// with the runtime-dispatched kernels of kernels.hpp.
+
+enum class CsvQuoting {
+    none,
+    text,  // the container id, the only text field
+    all,
+};
+
+struct CsvDialect {
+    char delimiter = ',';
+    char quote = '"';
+    CsvQuoting quoting = CsvQuoting::none;
+};
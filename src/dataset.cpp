@@ -0,0 +1,182 @@
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "dataset.hpp"
+
+namespace {
+
+constexpr uint64_t DATASET_ALIGNMENT = 4096;
+
+constexpr uint64_t align_up(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void write_zeros(std::ofstream* out, uint64_t count) {
+    const std::array<char, 4096> zeros{};
+    while (count > 0) {
+        const auto chunk = std::min<uint64_t>(count, zeros.size());
+        out->write(zeros.data(), static_cast<std::streamsize>(chunk));
+        count -= chunk;
+    }
+}
+
+}  // namespace
+
+std::string_view DatasetHeader::format_name() const {
+    return {format.data(), strnlen(format.data(), format.size())};
+}
+
+std::string_view DatasetHeader::workload_name() const {
+    return {workload.data(), strnlen(workload.data(), workload.size())};
+}
+
+std::string_view DatasetHeader::csv_dialect_name() const {
+    return {csv_dialect.data(), strnlen(csv_dialect.data(), csv_dialect.size())};
+}
+
+DatasetHeader write_dataset(const std::string& path,
+                            std::string_view format,
+                            std::string_view workload,
+                            std::string_view csv_dialect,
+                            uint64_t seed,
+                            const DatasetView& dataset) {
+    if (format.size() >= DATASET_FORMAT_NAME_SIZE) {
+        throw std::runtime_error(fmt::format("Format name too long: {}", format));
+    }
+    if (workload.size() >= DATASET_FORMAT_NAME_SIZE) {
+        throw std::runtime_error(fmt::format("Workload name too long: {}", workload));
+    }
+    if (csv_dialect.size() >= DATASET_FORMAT_NAME_SIZE) {
+        throw std::runtime_error(fmt::format("CSV dialect name too long: {}", csv_dialect));
+    }
+
+    DatasetHeader header{};
+    header.magic = DATASET_MAGIC;
+    header.version = DATASET_VERSION;
+    header.tuple_size_bytes = sizeof(tuple_size_t);
+    std::copy(begin(format), end(format), begin(header.format));
+    std::copy(begin(workload), end(workload), begin(header.workload));
+    std::copy(begin(csv_dialect), end(csv_dialect), begin(header.csv_dialect));
+    header.seed = seed;
+    header.tuple_count = dataset.tuple_sizes.size();
+    header.memory_size = dataset.memory.size();
+    header.tuple_sizes_offset = align_up(sizeof(DatasetHeader), alignof(tuple_size_t));
+    header.memory_offset = align_up(
+        header.tuple_sizes_offset + dataset.tuple_sizes.size_bytes(), DATASET_ALIGNMENT);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error(fmt::format("Could not open {} for writing", path));
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_zeros(&out, header.tuple_sizes_offset - sizeof(header));
+    out.write(reinterpret_cast<const char*>(dataset.tuple_sizes.data()),
+              static_cast<std::streamsize>(dataset.tuple_sizes.size_bytes()));
+    const uint64_t tuple_sizes_end = header.tuple_sizes_offset + dataset.tuple_sizes.size_bytes();
+    write_zeros(&out, header.memory_offset - tuple_sizes_end);
+    out.write(reinterpret_cast<const char*>(dataset.memory.data()),
+              static_cast<std::streamsize>(dataset.memory.size()));
+    write_zeros(&out, MEMORY_PADDING);
+
+    out.close();
+    if (!out) {
+        throw std::runtime_error(fmt::format("Could not write dataset to {}", path));
+    }
+    return header;
+}
+
+MappedDataset::MappedDataset(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);  // NOLINT(hicpp-signed-bitwise)
+    if (fd < 0) {
+        throw std::runtime_error(fmt::format("Could not open {}: {}", path, strerror(errno)));
+    }
+
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0 ||
+        file_stat.st_size < static_cast<off_t>(sizeof(DatasetHeader))) {
+        close(fd);
+        throw std::runtime_error(fmt::format("{} is not a dataset file", path));
+    }
+    mapping_size_ = static_cast<size_t>(file_stat.st_size);
+
+    // MAP_SHARED: processes mapping the same file share the same physical pages.
+    // MAP_POPULATE: fault everything in now instead of during the warmup.
+    void* mapping = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {  // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+        throw std::runtime_error(fmt::format("Could not map {}: {}", path, strerror(errno)));
+    }
+    mapping_ = static_cast<std::byte*>(mapping);
+
+    const DatasetHeader& h = header();
+    const auto invalid = [&](std::string_view reason) {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        return std::runtime_error(fmt::format("Invalid dataset file {}: {}", path, reason));
+    };
+
+    if (h.magic != DATASET_MAGIC) {
+        throw invalid("bad magic");
+    }
+    if (h.version != DATASET_VERSION) {
+        throw invalid(fmt::format("version {}, expected {}", h.version, DATASET_VERSION));
+    }
+    if (h.tuple_size_bytes != sizeof(tuple_size_t)) {
+        throw invalid(fmt::format("written with {} byte tuple sizes, this build uses {}",
+                                  h.tuple_size_bytes, sizeof(tuple_size_t)));
+    }
+    // Header, tuple sizes, memory and padding in this order. Compares against the space left
+    // instead of adding up the sizes, which a corrupted header could make wrap around.
+    if (h.tuple_sizes_offset < sizeof(DatasetHeader) ||
+        h.tuple_sizes_offset % alignof(tuple_size_t) != 0 ||
+        h.memory_offset % DATASET_ALIGNMENT != 0 ||
+        h.tuple_sizes_offset > h.memory_offset || h.memory_offset > mapping_size_ ||
+        h.tuple_count > (h.memory_offset - h.tuple_sizes_offset) / sizeof(tuple_size_t) ||
+        mapping_size_ - h.memory_offset < MEMORY_PADDING ||
+        h.memory_size > mapping_size_ - h.memory_offset - MEMORY_PADDING) {
+        throw invalid("truncated or inconsistent offsets");
+    }
+    // The parsers walk the memory by the tuple sizes alone.
+    const DatasetView dataset = view();
+    if (std::accumulate(begin(dataset.tuple_sizes), end(dataset.tuple_sizes), uint64_t{0}) !=
+        h.memory_size) {
+        throw invalid("tuple sizes do not add up to the memory size");
+    }
+}
+
+MappedDataset::~MappedDataset() {
+    if (mapping_ != nullptr) {
+        munmap(mapping_, mapping_size_);
+    }
+}
+
+MappedDataset::MappedDataset(MappedDataset&& other) noexcept
+    : mapping_(std::exchange(other.mapping_, nullptr)),
+      mapping_size_(std::exchange(other.mapping_size_, 0)) {}
+
+MappedDataset& MappedDataset::operator=(MappedDataset&& other) noexcept {
+    std::swap(mapping_, other.mapping_);
+    std::swap(mapping_size_, other.mapping_size_);
+    return *this;
+}
+
+DatasetView MappedDataset::view() const {
+    const DatasetHeader& h = header();
+    return {
+        std::span(mapping_ + h.memory_offset, h.memory_size),
+        std::span(reinterpret_cast<const tuple_size_t*>(mapping_ + h.tuple_sizes_offset),
+                  h.tuple_count),
+    };
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "bench.hpp"
+
+// On-disk layout of a dataset file (all integers in host byte order):
+//   DatasetHeader
+//   tuple_count * tuple_size_t             at header.tuple_sizes_offset
+//   memory_size bytes of tuples            at header.memory_offset (page aligned)
+//   MEMORY_PADDING zero bytes
+// Files are mapped read-only and shared, so several bench processes can use one copy of the data
+// from the page cache -- or from memory directly when the file lives on /dev/shm.
+constexpr std::array<char, 8> DATASET_MAGIC = {'T', 'M', 'B', 'D', 'A', 'T', 'A', '\0'};
+constexpr uint32_t DATASET_VERSION = 3;
+constexpr size_t DATASET_FORMAT_NAME_SIZE = 32;
+
+struct DatasetHeader {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t tuple_size_bytes;  // sizeof(tuple_size_t) of the writer
+    std::array<char, DATASET_FORMAT_NAME_SIZE> format;  // null-terminated, e.g. "json"
+    // null-terminated --workload and --float-format, e.g. "telemetry/2dp"
+    std::array<char, DATASET_FORMAT_NAME_SIZE> workload;
+    // null-terminated --csv-delimiter and --csv-quoting of csv-lines tuples, e.g. ",/none", empty
+    // for all other formats
+    std::array<char, DATASET_FORMAT_NAME_SIZE> csv_dialect;
+    uint64_t seed;  // --seed the tuples were generated with
+    uint64_t tuple_count;
+    uint64_t memory_size;
+    uint64_t tuple_sizes_offset;
+    uint64_t memory_offset;
+
+    [[nodiscard]] std::string_view format_name() const;
+    [[nodiscard]] std::string_view workload_name() const;
+    [[nodiscard]] std::string_view csv_dialect_name() const;
+};
+
+// Returns the header that was written. Throws std::runtime_error on I/O errors.
+DatasetHeader write_dataset(const std::string& path,
+                            std::string_view format,
+                            std::string_view workload,
+                            std::string_view csv_dialect,
+                            uint64_t seed,
+                            const DatasetView& dataset);
+
+// Read-only mapping of a dataset file. Throws std::runtime_error if the file can not be mapped or
+// is not a valid dataset file written by a compatible build.
+class MappedDataset {
+   public:
+    explicit MappedDataset(const std::string& path);
+    ~MappedDataset();
+
+    MappedDataset(const MappedDataset&) = delete;
+    MappedDataset& operator=(const MappedDataset&) = delete;
+    MappedDataset(MappedDataset&& other) noexcept;
+    MappedDataset& operator=(MappedDataset&& other) noexcept;
+
+    [[nodiscard]] const DatasetHeader& header() const {
+        return *reinterpret_cast<const DatasetHeader*>(mapping_);
+    }
+    [[nodiscard]] DatasetView view() const;
+
+   private:
+    std::byte* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+};
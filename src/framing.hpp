@@ -0,0 +1,50 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// Finds record boundaries in newline-delimited input: stores the offset one past each '\n' in
+// [begin, end), relative to begin, into line_ends until max_count were found. Returns how many
+// were found. May read up to 31 bytes past `end` (covered by MEMORY_PADDING), but never reports
+// newlines there.
+inline size_t find_line_ends(const std::byte* begin,
+                             const std::byte* end,
+                             size_t max_count,
+                             uint32_t* line_ends) {
+    size_t count = 0;
+    const auto* ptr = reinterpret_cast<const char*>(begin);
+    const auto* const end_ptr = reinterpret_cast<const char*>(end);
+
+#ifdef __AVX2__
+    constexpr size_t block_size = 32;
+    const __m256i newline = _mm256_set1_epi8('\n');
+#else
+    constexpr size_t block_size = 16;
+    const __m128i newline = _mm_set1_epi8('\n');
+#endif
+
+    while (ptr < end_ptr && count < max_count) {
+#ifdef __AVX2__
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline)));
+#else
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+        auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+#endif
+        const auto remaining = static_cast<size_t>(end_ptr - ptr);
+        if (remaining < block_size) {
+            mask &= (uint32_t{1} << remaining) - 1;
+        }
+
+        const auto block_offset = static_cast<uint32_t>(ptr - reinterpret_cast<const char*>(begin));
+        while (mask != 0 && count < max_count) {
+            line_ends[count++] = block_offset + static_cast<uint32_t>(std::countr_zero(mask)) + 1;
+            mask &= mask - 1;
+        }
+        ptr += block_size;
+    }
+    return count;
+}
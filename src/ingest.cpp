@@ -0,0 +1,447 @@
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#ifdef BENCH_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include "ingest.hpp"
+#include "latency.hpp"
+
+namespace {
+
+// Largest write of the sender, so it does not hand the kernel the whole dataset at once.
+constexpr size_t SEND_CHUNK_SIZE = 256ULL * 1024;
+// How long receivers block before looking at the stop flag again.
+constexpr int RECEIVE_TIMEOUT_MS = 100;
+
+std::runtime_error errno_error(std::string_view what) {
+    return std::runtime_error(fmt::format("{}: {}", what, strerror(errno)));
+}
+
+class EpollReceiver : public IngestReceiver {
+   public:
+    EpollReceiver(int fd, size_t buffer_size, size_t padding)
+        : fd_(fd), buffer_size_(buffer_size), buffer_(buffer_size + padding) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg, hicpp-vararg, hicpp-signed-bitwise)
+        if (fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK) != 0) {
+            throw errno_error("Could not make socket non-blocking");
+        }
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            throw errno_error("Could not create epoll instance");
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd_;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd_, &event) != 0) {
+            close(epoll_fd_);
+            throw errno_error("Could not add socket to epoll instance");
+        }
+    }
+    ~EpollReceiver() override { close(epoll_fd_); }
+
+    EpollReceiver(const EpollReceiver&) = delete;
+    EpollReceiver& operator=(const EpollReceiver&) = delete;
+    EpollReceiver(EpollReceiver&&) = delete;
+    EpollReceiver& operator=(EpollReceiver&&) = delete;
+
+    void run(const std::atomic<bool>& stop_flag, const DataCallback& on_data) override {
+        while (!stop_flag.load(std::memory_order_relaxed)) {
+            const uint64_t receive_start = tsc_begin();
+            const ssize_t received = recv(fd_, buffer_.data(), buffer_size_, 0);
+            uint64_t calls = 1;
+            if (received < 0 && errno == EAGAIN) {
+                epoll_event event{};
+                epoll_wait(epoll_fd_, &event, 1, RECEIVE_TIMEOUT_MS);
+                ++calls;
+            }
+            receive_cycles.fetch_add(tsc_end() - receive_start, std::memory_order_relaxed);
+            syscalls.fetch_add(calls, std::memory_order_relaxed);
+
+            if (received > 0) {
+                received_bytes.fetch_add(static_cast<size_t>(received), std::memory_order_relaxed);
+                on_data({buffer_.data(), static_cast<size_t>(received)});
+            } else if (received == 0) {
+                break;
+            } else if (errno != EAGAIN && errno != EINTR) {
+                throw errno_error("Could not receive from socket");
+            }
+        }
+        shutdown(fd_, SHUT_RDWR);
+    }
+
+   private:
+    int fd_;
+    int epoll_fd_ = -1;
+    size_t buffer_size_;
+    std::vector<std::byte> buffer_;
+};
+
+#ifdef BENCH_HAVE_LIBURING
+class UringReceiver : public IngestReceiver {
+   public:
+    UringReceiver(int fd, size_t buffer_size, size_t padding)
+        : fd_(fd), buffer_size_(buffer_size), buffer_stride_(buffer_size + padding) {
+        if (const int ret = io_uring_queue_init(RING_ENTRIES, &ring_, 0); ret < 0) {
+            throw std::runtime_error(
+                fmt::format("Could not set up io_uring: {}", strerror(-ret)));
+        }
+        int ret = 0;
+        buffer_ring_ = io_uring_setup_buf_ring(&ring_, BUFFER_COUNT, BUFFER_GROUP, 0, &ret);
+        if (buffer_ring_ == nullptr) {
+            io_uring_queue_exit(&ring_);
+            throw std::runtime_error(
+                fmt::format("Could not set up io_uring buffer ring: {}", strerror(-ret)));
+        }
+        buffers_.resize(BUFFER_COUNT * buffer_stride_);
+        for (uint16_t id = 0; id < BUFFER_COUNT; ++id) {
+            provide_buffer(id);
+        }
+        io_uring_buf_ring_advance(buffer_ring_, BUFFER_COUNT);
+    }
+    ~UringReceiver() override {
+        io_uring_free_buf_ring(&ring_, buffer_ring_, BUFFER_COUNT, BUFFER_GROUP);
+        io_uring_queue_exit(&ring_);
+    }
+
+    UringReceiver(const UringReceiver&) = delete;
+    UringReceiver& operator=(const UringReceiver&) = delete;
+    UringReceiver(UringReceiver&&) = delete;
+    UringReceiver& operator=(UringReceiver&&) = delete;
+
+    void run(const std::atomic<bool>& stop_flag, const DataCallback& on_data) override {
+        arm();
+        while (!stop_flag.load(std::memory_order_relaxed)) {
+            // Completions that are already posted are reaped without a syscall.
+            const uint64_t calls = io_uring_cq_ready(&ring_) == 0 ? 1 : 0;
+            const uint64_t receive_start = tsc_begin();
+            io_uring_cqe* cqe = nullptr;
+            __kernel_timespec timeout{0, RECEIVE_TIMEOUT_MS * 1000LL * 1000};
+            const int ret = io_uring_wait_cqe_timeout(&ring_, &cqe, &timeout);
+            receive_cycles.fetch_add(tsc_end() - receive_start, std::memory_order_relaxed);
+            syscalls.fetch_add(calls, std::memory_order_relaxed);
+
+            if (ret == -ETIME || ret == -EINTR) {
+                continue;
+            }
+            if (ret < 0) {
+                throw std::runtime_error(
+                    fmt::format("Could not wait for io_uring completion: {}", strerror(-ret)));
+            }
+
+            const int result = cqe->res;
+            const unsigned flags = cqe->flags;
+            io_uring_cqe_seen(&ring_, cqe);
+            if (result == -ENOBUFS) {
+                // All buffers were in use, the multishot receive ended.
+                arm();
+                continue;
+            }
+            if (result <= 0) {
+                if (result < 0) {
+                    throw std::runtime_error(
+                        fmt::format("Could not receive from socket: {}", strerror(-result)));
+                }
+                break;
+            }
+
+            const auto id = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+            received_bytes.fetch_add(static_cast<size_t>(result), std::memory_order_relaxed);
+            on_data({buffer(id), static_cast<size_t>(result)});
+            provide_buffer(id);
+            io_uring_buf_ring_advance(buffer_ring_, 1);
+            if ((flags & IORING_CQE_F_MORE) == 0) {
+                arm();
+            }
+        }
+        shutdown(fd_, SHUT_RDWR);
+    }
+
+   private:
+    static constexpr unsigned RING_ENTRIES = 8;
+    static constexpr uint16_t BUFFER_COUNT = 16;  // power of two
+    static constexpr int BUFFER_GROUP = 0;
+
+    std::byte* buffer(uint16_t id) { return buffers_.data() + id * buffer_stride_; }
+
+    void provide_buffer(uint16_t id) {
+        io_uring_buf_ring_add(buffer_ring_, buffer(id), static_cast<unsigned>(buffer_size_), id,
+                              io_uring_buf_ring_mask(BUFFER_COUNT), 0);
+    }
+
+    void arm() {
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+        io_uring_prep_recv_multishot(sqe, fd_, nullptr, 0, 0);
+        sqe->flags |= IOSQE_BUFFER_SELECT;
+        sqe->buf_group = BUFFER_GROUP;
+        io_uring_submit(&ring_);
+        syscalls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    int fd_;
+    size_t buffer_size_;
+    size_t buffer_stride_;
+    io_uring ring_{};
+    io_uring_buf_ring* buffer_ring_ = nullptr;
+    std::vector<std::byte> buffers_;
+};
+
+class UringFileReader : public IngestReceiver {
+   public:
+    UringFileReader(const std::string& path,
+                    uint64_t offset,
+                    uint64_t size,
+                    size_t buffer_size,
+                    size_t depth,
+                    bool direct_io,
+                    size_t padding)
+        : offset_(offset),
+          size_(size),
+          // O_DIRECT needs page aligned offsets, lengths and buffers.
+          buffer_size_(align_up(buffer_size, DIRECT_IO_ALIGNMENT)),
+          buffer_stride_(align_up(buffer_size_ + padding, DIRECT_IO_ALIGNMENT)),
+          depth_(depth),
+          chunks_per_pass_((size + buffer_size_ - 1) / buffer_size_),
+          results_(depth) {
+        // Every pass reads at least one chunk.
+        if (size == 0) {
+            throw std::runtime_error(fmt::format("{} holds no tuples to read", path));
+        }
+        if (direct_io && offset % DIRECT_IO_ALIGNMENT != 0) {
+            throw std::runtime_error(fmt::format("{} is not page aligned for O_DIRECT", offset));
+        }
+        // NOLINTNEXTLINE(hicpp-signed-bitwise)
+        fd_ = open(path.c_str(), O_RDONLY | O_CLOEXEC | (direct_io ? O_DIRECT : 0));
+        if (fd_ < 0) {
+            throw errno_error(fmt::format("Could not open {}", path));
+        }
+        buffers_ = static_cast<std::byte*>(
+            std::aligned_alloc(DIRECT_IO_ALIGNMENT, buffer_stride_ * depth_));
+        if (buffers_ == nullptr) {
+            close(fd_);
+            throw std::bad_alloc();
+        }
+        if (const int ret = io_uring_queue_init(static_cast<unsigned>(depth_), &ring_, 0);
+            ret < 0) {
+            std::free(buffers_);  // NOLINT(cppcoreguidelines-no-malloc)
+            close(fd_);
+            throw std::runtime_error(
+                fmt::format("Could not set up io_uring: {}", strerror(-ret)));
+        }
+    }
+    ~UringFileReader() override {
+        io_uring_queue_exit(&ring_);
+        std::free(buffers_);  // NOLINT(cppcoreguidelines-no-malloc)
+        close(fd_);
+    }
+
+    UringFileReader(const UringFileReader&) = delete;
+    UringFileReader& operator=(const UringFileReader&) = delete;
+    UringFileReader(UringFileReader&&) = delete;
+    UringFileReader& operator=(UringFileReader&&) = delete;
+
+    void run(const std::atomic<bool>& stop_flag, const DataCallback& on_data) override {
+        // Chunk k of the endless stream is read into buffer k % depth.
+        for (size_t chunk = 0; chunk < depth_; ++chunk) {
+            prepare_read(chunk);
+        }
+        submit();
+        size_t in_flight = depth_;
+
+        for (size_t chunk = 0; !stop_flag.load(std::memory_order_relaxed); ++chunk) {
+            const size_t buffer = chunk % depth_;
+            while (!results_[buffer] && !stop_flag.load(std::memory_order_relaxed)) {
+                reap(true);
+                --in_flight;
+            }
+            if (!results_[buffer]) {
+                break;
+            }
+
+            const size_t length = chunk_length(chunk);
+            const int result = *results_[buffer];
+            if (result < 0 || static_cast<size_t>(result) < length) {
+                throw std::runtime_error(
+                    fmt::format("Could not read chunk at offset {}: {}", chunk_offset(chunk),
+                                result < 0 ? strerror(-result) : "short read"));
+            }
+            received_bytes.fetch_add(length, std::memory_order_relaxed);
+            on_data({buffers_ + buffer * buffer_stride_, length});
+
+            results_[buffer].reset();
+            prepare_read(chunk + depth_);
+            submit();
+            ++in_flight;
+        }
+
+        // The kernel must not write into the buffers once they are freed or reused.
+        while (in_flight > 0) {
+            reap(false);
+            --in_flight;
+        }
+        std::fill(results_.begin(), results_.end(), std::nullopt);
+    }
+
+   private:
+    static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;
+
+    static constexpr size_t align_up(size_t value, size_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    [[nodiscard]] uint64_t chunk_offset(size_t chunk) const {
+        return (chunk % chunks_per_pass_) * buffer_size_;
+    }
+    [[nodiscard]] size_t chunk_length(size_t chunk) const {
+        return std::min<uint64_t>(buffer_size_, size_ - chunk_offset(chunk));
+    }
+
+    void prepare_read(size_t chunk) {
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+        // Whole buffers, so O_DIRECT lengths stay aligned. Reads past the end of the file are
+        // short, the dataset's padding makes sure the chunk itself is complete.
+        io_uring_prep_read(sqe, fd_, buffers_ + (chunk % depth_) * buffer_stride_,
+                           static_cast<unsigned>(buffer_size_), offset_ + chunk_offset(chunk));
+        io_uring_sqe_set_data64(sqe, chunk % depth_);
+    }
+
+    void submit() {
+        const uint64_t submit_start = tsc_begin();
+        io_uring_submit(&ring_);
+        receive_cycles.fetch_add(tsc_end() - submit_start, std::memory_order_relaxed);
+        syscalls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Waits for one completion and stores its result.
+    void reap(bool count) {
+        const uint64_t calls = io_uring_cq_ready(&ring_) == 0 ? 1 : 0;
+        const uint64_t wait_start = tsc_begin();
+        io_uring_cqe* cqe = nullptr;
+        if (const int ret = io_uring_wait_cqe(&ring_, &cqe); ret < 0) {
+            throw std::runtime_error(
+                fmt::format("Could not wait for io_uring completion: {}", strerror(-ret)));
+        }
+        if (count) {
+            receive_cycles.fetch_add(tsc_end() - wait_start, std::memory_order_relaxed);
+            syscalls.fetch_add(calls, std::memory_order_relaxed);
+        }
+        results_[io_uring_cqe_get_data64(cqe)] = cqe->res;
+        io_uring_cqe_seen(&ring_, cqe);
+    }
+
+    int fd_ = -1;
+    uint64_t offset_;
+    uint64_t size_;
+    size_t buffer_size_;
+    size_t buffer_stride_;
+    size_t depth_;
+    uint64_t chunks_per_pass_;
+    std::byte* buffers_ = nullptr;
+    io_uring ring_{};
+    std::vector<std::optional<int>> results_;  // per buffer, set once its read completed
+};
+#endif
+
+}  // namespace
+
+bool uring_supported() {
+#ifdef BENCH_HAVE_LIBURING
+    return true;
+#else
+    return false;
+#endif
+}
+
+SocketConnection::SocketConnection() {
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds_.data()) != 0) {
+        throw errno_error("Could not create socket pair");
+    }
+}
+
+SocketConnection::~SocketConnection() {
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+SocketConnection::SocketConnection(SocketConnection&& other) noexcept
+    : fds_(std::exchange(other.fds_, {-1, -1})) {}
+
+SocketConnection& SocketConnection::operator=(SocketConnection&& other) noexcept {
+    std::swap(fds_, other.fds_);
+    return *this;
+}
+
+void run_socket_sender(int fd, std::span<const std::byte> memory) {
+    size_t offset = 0;
+    while (true) {
+        const size_t length = std::min(SEND_CHUNK_SIZE, memory.size() - offset);
+        const ssize_t sent = send(fd, memory.data() + offset, length, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // EPIPE / ECONNRESET: the receiver is done.
+            return;
+        }
+        offset += static_cast<size_t>(sent);
+        if (offset == memory.size()) {
+            offset = 0;
+        }
+    }
+}
+
+std::unique_ptr<IngestReceiver> make_socket_receiver(ReceiverKind kind,
+                                                     int fd,
+                                                     size_t buffer_size,
+                                                     size_t padding) {
+    switch (kind) {
+        case ReceiverKind::epoll:
+            return std::make_unique<EpollReceiver>(fd, buffer_size, padding);
+        case ReceiverKind::uring:
+#ifdef BENCH_HAVE_LIBURING
+            return std::make_unique<UringReceiver>(fd, buffer_size, padding);
+#else
+            throw std::runtime_error("io_uring receivers need a build with liburing");
+#endif
+    }
+    throw std::runtime_error("Unknown receiver kind");
+}
+
+std::unique_ptr<IngestReceiver> make_file_reader(const std::string& path,
+                                                 uint64_t offset,
+                                                 uint64_t size,
+                                                 size_t buffer_size,
+                                                 size_t depth,
+                                                 bool direct_io,
+                                                 size_t padding) {
+#ifdef BENCH_HAVE_LIBURING
+    return std::make_unique<UringFileReader>(path, offset, size, buffer_size, depth, direct_io,
+                                             padding);
+#else
+    static_cast<void>(path);
+    static_cast<void>(offset);
+    static_cast<void>(size);
+    static_cast<void>(buffer_size);
+    static_cast<void>(depth);
+    static_cast<void>(direct_io);
+    static_cast<void>(padding);
+    throw std::runtime_error("File ingest needs a build with liburing");
+#endif
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+
+// Ingest modes: instead of reading the dataset from memory, every parser thread receives it as a
+// byte stream, either from a sender thread over its own AF_UNIX stream socket or by reading the
+// dataset file. io_uring needs liburing (BENCH_HAVE_LIBURING).
+
+enum class ReceiverKind {
+    epoll,  // non-blocking recv() into one reusable buffer, epoll_wait() while there is no data
+    uring,  // io_uring multishot recv into a ring of provided buffers
+};
+
+[[nodiscard]] bool uring_supported();
+
+// Connected pair of AF_UNIX stream sockets, both closed on destruction.
+class SocketConnection {
+   public:
+    SocketConnection();
+    ~SocketConnection();
+
+    SocketConnection(const SocketConnection&) = delete;
+    SocketConnection& operator=(const SocketConnection&) = delete;
+    SocketConnection(SocketConnection&& other) noexcept;
+    SocketConnection& operator=(SocketConnection&& other) noexcept;
+
+    [[nodiscard]] int sender_fd() const { return fds_[0]; }
+    [[nodiscard]] int receiver_fd() const { return fds_[1]; }
+
+   private:
+    std::array<int, 2> fds_ = {-1, -1};
+};
+
+// Writes `memory` to fd over and over until the receiving side shuts the connection down.
+void run_socket_sender(int fd, std::span<const std::byte> memory);
+
+// Receiving end of the byte stream of one parser thread.
+class IngestReceiver {
+   public:
+    using DataCallback = std::function<void(std::span<const std::byte>)>;
+
+    virtual ~IngestReceiver() = default;
+
+    // Hands received bytes to on_data, in order, until stop_flag is set or the sender is gone. The
+    // bytes are only valid during the call and followed by the padding given on creation.
+    virtual void run(const std::atomic<bool>& stop_flag, const DataCallback& on_data) = 0;
+
+    // TSC ticks spent in receive / read syscalls, including waiting for data
+    alignas(64) std::atomic<uint64_t> receive_cycles = 0;
+    std::atomic<uint64_t> syscalls = 0;
+    std::atomic<uint64_t> received_bytes = 0;
+};
+
+// Receives from a socket into buffers of buffer_size bytes, each followed by `padding` readable
+// bytes. run() shuts the connection down before returning, so the sender stops as well.
+std::unique_ptr<IngestReceiver> make_socket_receiver(ReceiverKind kind,
+                                                     int fd,
+                                                     size_t buffer_size,
+                                                     size_t padding);
+
+// Reads bytes [offset, offset + size) of a file over and over with io_uring, in chunks of
+// buffer_size bytes. `depth` buffers rotate: while one is parsed, the reads of the next depth - 1
+// chunks are in flight. With direct_io, the page cache is bypassed (O_DIRECT) and offset has to be
+// page aligned.
+std::unique_ptr<IngestReceiver> make_file_reader(const std::string& path,
+                                                 uint64_t offset,
+                                                 uint64_t size,
+                                                 size_t buffer_size,
+                                                 size_t depth,
+                                                 bool direct_io,
+                                                 size_t padding);
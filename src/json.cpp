@@ -1,3 +1,4 @@
+#include <fast_float/fast_float.h>
 #include <fmt/compile.h>
 #include <fmt/format.h>
 #include <rapidjson/document.h>
@@ -6,11 +7,14 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <string_view>
+#include <type_traits>
 #include <utility>
 
 #include "bench.hpp"
 #include "json.hpp"
+#include "schema.hpp"
 
 using namespace std::literals::string_view_literals;
 
@@ -83,10 +87,14 @@ struct NativeTupleHandler
                 state_ = kExpectAttrNameOrObjectEnd;
                 return true;
             default:
-                return false;
+                // floats without decimals, e.g. with --float-format shortest
+                return Double(static_cast<double>(val));
         }
     }
 
+    // rapidjson reports numbers below 2^32 here instead of Uint64()
+    bool Uint(unsigned val) { return Uint64(val); }
+
     bool String(const Ch* str, rapidjson::SizeType length, bool /*copy*/) {
         if (unlikely(state_ != kExpectContainerId)) {
             return false;
@@ -128,19 +136,19 @@ IMPL_VISIBILITY void serialize_json(const NativeTuple& tup, std::vector<std::byt
     fmt::format_to(std::back_inserter(local_buffer), FMT_COMPILE(R"({{
 "id": {},
 "timestamp": {},
-"load": {:f},
-"load_avg_1": {:f},
-"load_avg_5": {:f},
-"load_avg_15": {:f},
+"load": {},
+"load_avg_1": {},
+"load_avg_5": {},
+"load_avg_15": {},
 "container_id": "{:02x}"
 }}
 )"),
         tup.id,
         tup.timestamp,
-        tup.load,
-        tup.load_avg_1,
-        tup.load_avg_5,
-        tup.load_avg_15,
+        TextFloat{tup.load},
+        TextFloat{tup.load_avg_1},
+        TextFloat{tup.load_avg_5},
+        TextFloat{tup.load_avg_15},
         fmt::join(tup.container_id, "")
     );
     // clang-format on
@@ -153,6 +161,121 @@ IMPL_VISIBILITY void serialize_json(const NativeTuple& tup, std::vector<std::byt
               reinterpret_cast<char*>(buf->data() + old_size));
 }
 
+IMPL_VISIBILITY void serialize_ndjson(const NativeTuple& tup, std::vector<std::byte>* buf) {
+    // One tuple per line, no terminating null byte: The whole memory is one valid NDJSON stream.
+    thread_local fmt::memory_buffer local_buffer;
+    local_buffer.clear();
+
+    // clang-format off
+    fmt::format_to(std::back_inserter(local_buffer), FMT_COMPILE(
+        "{{\"id\":{},\"timestamp\":{},\"load\":{},\"load_avg_1\":{},\"load_avg_5\":{},"
+        "\"load_avg_15\":{},\"container_id\":\"{:02x}\"}}\n"),
+        tup.id,
+        tup.timestamp,
+        TextFloat{tup.load},
+        TextFloat{tup.load_avg_1},
+        TextFloat{tup.load_avg_5},
+        TextFloat{tup.load_avg_15},
+        fmt::join(tup.container_id, "")
+    );
+    // clang-format on
+
+    const auto old_size = buf->size();
+    buf->resize(old_size + local_buffer.size());
+    std::copy(begin(local_buffer), end(local_buffer),
+              reinterpret_cast<char*>(buf->data() + old_size));
+}
+
+// NativeTupleHandler for any schema: the key selects the field the next value is stored in.
+template <typename Schema>
+struct SchemaTupleHandler
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, SchemaTupleHandler<Schema>> {
+    explicit SchemaTupleHandler(typename Schema::Tuple* tup) : tup_(tup) {}
+
+    bool StartObject() {
+        if (unlikely(state_ != kExpectObjectStart)) {
+            return false;
+        }
+        state_ = kExpectAttrNameOrObjectEnd;
+        return true;
+    }
+
+    bool Key(const char* str, rapidjson::SizeType length, bool /*copy*/) {
+        if (unlikely(state_ != kExpectAttrNameOrObjectEnd)) {
+            return false;
+        }
+        field_ = Schema::field_index({str, length});
+        state_ = kExpectValue;
+        return likely(field_ != Schema::field_count);
+    }
+
+    bool Double(double val) {
+        return store([&](auto* value) {
+            if constexpr (std::is_same_v<std::remove_pointer_t<decltype(value)>, float>) {
+                *value = static_cast<float>(val);
+                return true;
+            }
+            return false;
+        });
+    }
+
+    bool Uint64(uint64_t val) {
+        return store([&](auto* value) {
+            using T = std::remove_pointer_t<decltype(value)>;
+            if constexpr (std::is_same_v<T, uint64_t> || std::is_same_v<T, float>) {
+                *value = static_cast<T>(val);
+                return true;
+            }
+            return false;
+        });
+    }
+
+    // rapidjson reports numbers below 2^32 here instead of Uint64()
+    bool Uint(unsigned val) { return Uint64(val); }
+
+    bool String(const char* str, rapidjson::SizeType length, bool /*copy*/) {
+        return store([&](auto* value) -> bool {
+            using T = std::remove_pointer_t<decltype(value)>;
+            if constexpr (is_inline_string<T>::value) {
+                return value->assign({str, length});
+            } else if constexpr (is_byte_array<T>::value) {
+                const auto result = parse_hex_bytes(str, str + length, value);
+                return likely(result.ec == std::errc() && result.ptr == str + length);
+            }
+            return false;
+        });
+    }
+
+    [[nodiscard]] bool EndObject(rapidjson::SizeType /*unused*/) const {
+        return state_ == kExpectAttrNameOrObjectEnd;
+    }
+
+    static bool Default() { return false; }
+
+   private:
+    // Calls store(&value) for the value of the current field.
+    template <typename Store>
+    bool store(const Store& store_value) {
+        if (unlikely(state_ != kExpectValue)) {
+            return false;
+        }
+        state_ = kExpectAttrNameOrObjectEnd;
+        return Schema::visit_field(
+            field_, [&](auto field) { return store_value(&decltype(field)::get(*tup_)); });
+    }
+
+    typename Schema::Tuple* tup_;
+    size_t field_ = 0;
+
+    enum State {
+        kExpectObjectStart,
+        kExpectAttrNameOrObjectEnd,
+        kExpectValue,
+    };
+
+    State state_{kExpectObjectStart};
+};
+
 IMPL_VISIBILITY bool parse_rapidjson(const std::byte* __restrict__ read_ptr,
                                      tuple_size_t tup_size,
                                      NativeTuple* tup) noexcept {
@@ -236,7 +359,8 @@ IMPL_VISIBILITY bool parse_simdjson(const std::byte* __restrict__ read_ptr,
                                     tuple_size_t tup_size,
                                     NativeTuple* tup) {
     static thread_local simdjson::ondemand::parser parser;
-    const simdjson::padded_string_view s(reinterpret_cast<const char*>(read_ptr), tup_size - 2,
+    // Everything but the terminating '\0' of json tuples or the '\n' of framed ndjson lines.
+    const simdjson::padded_string_view s(reinterpret_cast<const char*>(read_ptr), tup_size - 1,
                                          tup_size + simdjson::SIMDJSON_PADDING);
     simdjson::ondemand::document d = parser.iterate(s);
     tup->id = d["id"].get_uint64();
@@ -263,7 +387,7 @@ IMPL_VISIBILITY bool parse_simdjson_out_of_order(const std::byte* __restrict__ r
                                                  tuple_size_t tup_size,
                                                  NativeTuple* tup) {
     static thread_local simdjson::ondemand::parser parser;
-    const simdjson::padded_string_view s(reinterpret_cast<const char*>(read_ptr), tup_size - 2,
+    const simdjson::padded_string_view s(reinterpret_cast<const char*>(read_ptr), tup_size - 1,
                                          tup_size + simdjson::SIMDJSON_PADDING);
     simdjson::ondemand::document d = parser.iterate(s);
 
@@ -291,7 +415,7 @@ IMPL_VISIBILITY bool parse_simdjson_error_codes(const std::byte* __restrict__ re
                                                 tuple_size_t tup_size,
                                                 NativeTuple* tup) noexcept {
     static thread_local simdjson::ondemand::parser parser;
-    const simdjson::padded_string_view s(reinterpret_cast<const char*>(read_ptr), tup_size - 2,
+    const simdjson::padded_string_view s(reinterpret_cast<const char*>(read_ptr), tup_size - 1,
                                          tup_size + simdjson::SIMDJSON_PADDING);
     simdjson::ondemand::document d;
     if (unlikely(parser.iterate(s).get(d) != 0U)) {
@@ -329,7 +453,7 @@ IMPL_VISIBILITY bool parse_simdjson_error_codes_early(const std::byte* __restric
                                                       tuple_size_t tup_size,
                                                       NativeTuple* tup) noexcept {
     static thread_local simdjson::ondemand::parser parser;
-    const simdjson::padded_string_view s(reinterpret_cast<const char*>(read_ptr), tup_size - 2,
+    const simdjson::padded_string_view s(reinterpret_cast<const char*>(read_ptr), tup_size - 1,
                                          tup_size + simdjson::SIMDJSON_PADDING);
     simdjson::ondemand::document d;
     if (unlikely(parser.iterate(s).get(d) != 0U)) {
@@ -365,7 +489,7 @@ IMPL_VISIBILITY bool parse_simdjson_unescaped(const std::byte* __restrict__ read
                                               tuple_size_t tup_size,
                                               NativeTuple* tup) {
     static thread_local simdjson::ondemand::parser parser;
-    const simdjson::padded_string_view s(reinterpret_cast<const char*>(read_ptr), tup_size - 2,
+    const simdjson::padded_string_view s(reinterpret_cast<const char*>(read_ptr), tup_size - 1,
                                          tup_size + simdjson::SIMDJSON_PADDING);
     simdjson::ondemand::document d = parser.iterate(s);
 
@@ -397,15 +521,299 @@ IMPL_VISIBILITY bool parse_simdjson_unescaped(const std::byte* __restrict__ read
     return true;
 }
 
-// clang-format off
-template void generate_tuples<serialize_json>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, std::mutex* mutex);
+// What serialize_json writes in front of every value and behind the last one.
+constexpr std::array<std::string_view, 7> json_fast_path_keys{
+    "{\n\"id\": "sv,         ",\n\"timestamp\": "sv,  ",\n\"load\": "sv,
+    ",\n\"load_avg_1\": "sv, ",\n\"load_avg_5\": "sv, ",\n\"load_avg_15\": "sv,
+    ",\n\"container_id\": \""sv,
+};
+constexpr std::string_view json_fast_path_end = "\"\n}\n\0"sv;
+
+IMPL_VISIBILITY bool parse_json_fast_path(const std::byte* __restrict__ read_ptr,
+                                          tuple_size_t tup_size,
+                                          NativeTuple* tup) noexcept {
+    // Speculates that the tuple is laid out exactly like serialize_json writes it: the keys are
+    // compared as a whole instead of being looked up, the values are parsed in place. Anything
+    // else, including invalid input, goes to simdjson.
+    const auto* str = reinterpret_cast<const char*>(read_ptr);
+    const auto* const str_end = str + tup_size;
+
+    // Constant-size memcmp, a few wide compares. May read past the tuple, into MEMORY_PADDING.
+    const auto expect = [&](std::string_view literal) -> bool {
+        if (std::memcmp(str, literal.data(), literal.size()) != 0) {
+            return false;
+        }
+        str += literal.size();
+        return true;
+    };
+    const auto next_uint = [&](uint64_t* value) -> bool {
+        size_t len = 0;
+        while (str[len] >= '0' && str[len] <= '9') {
+            ++len;
+        }
+        // JSON has no leading zeros, the kernel rejects len 0 and more than 20 digits
+        if ((len > 1 && *str == '0') || !kernels.parse_uint_digits(str, len, value)) {
+            return false;
+        }
+        str += len;
+        return true;
+    };
+    const auto next_float = [&](float* value) -> bool {
+        // fast_float accepts more than JSON does ("01.5", "-.5", "1."), so check the grammar
+        // first: no leading zeros and at least one digit in the integer, fraction and exponent.
+        const auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+        const char* end = str;
+        end += static_cast<ptrdiff_t>(*end == '-');
+        if (*end == '0') {
+            ++end;
+        } else if (is_digit(*end)) {
+            while (is_digit(*end)) {
+                ++end;
+            }
+        } else {
+            return false;
+        }
+        if (*end == '.') {
+            ++end;
+            if (!is_digit(*end)) {
+                return false;
+            }
+            while (is_digit(*end)) {
+                ++end;
+            }
+        }
+        if (*end == 'e' || *end == 'E') {
+            ++end;
+            end += static_cast<ptrdiff_t>(*end == '+' || *end == '-');
+            if (!is_digit(*end)) {
+                return false;
+            }
+            while (is_digit(*end)) {
+                ++end;
+            }
+        }
+        if (end > str_end) {
+            return false;
+        }
+
+        const auto result = fast_float::from_chars(str, end, *value);
+        if (result.ec != std::errc() || result.ptr != end) {
+            return false;
+        }
+        str = end;
+        return true;
+    };
+
+    const auto& keys = json_fast_path_keys;
+    const bool hit =
+        expect(keys[0]) && next_uint(&tup->id) && expect(keys[1]) &&
+        next_uint(&tup->timestamp) && expect(keys[2]) && next_float(&tup->load) &&
+        expect(keys[3]) && next_float(&tup->load_avg_1) && expect(keys[4]) &&
+        next_float(&tup->load_avg_5) && expect(keys[5]) && next_float(&tup->load_avg_15) &&
+        expect(keys[6]) &&
+        str_end - str == static_cast<ptrdiff_t>(2 * HASH_BYTES + json_fast_path_end.size()) &&
+        tup->set_container_id_from_hex_string(str, str + 2 * HASH_BYTES).ec == std::errc() &&
+        std::memcmp(str + 2 * HASH_BYTES, json_fast_path_end.data(),
+                    json_fast_path_end.size()) == 0;
+    if (likely(hit)) {
+        return true;
+    }
+
+    ++thread_fallback_tuples;
+    return parse_simdjson_error_codes(read_ptr, tup_size, tup);
+}
+
+IMPL_VISIBILITY bool parse_simdjson_many(const std::byte* __restrict__ read_ptr,
+                                         size_t batch_size,
+                                         size_t tuple_count,
+                                         const ParseOptions& options,
+                                         NativeTuple* tups) noexcept {
+    static thread_local simdjson::ondemand::parser parser;
+#ifdef SIMDJSON_THREADS_ENABLED
+    // Otherwise, simdjson runs stage 1 of the next window on a second thread whenever the run is
+    // larger than one window -- we want to measure one core per benchmark thread.
+    parser.threaded = false;
+#endif
+
+    // The padding bytes behind the end of the batch are either the next tuples or the reserved
+    // slack at the end of the memory.
+    simdjson::ondemand::document_stream stream;
+    if (unlikely(parser
+                     .iterate_many(reinterpret_cast<const char*>(read_ptr), batch_size,
+                                   options.batch_window)
+                     .get(stream) != 0U)) {
+        return false;
+    }
+
+    size_t parsed_count = 0;
+    for (auto d : stream) {
+        if (unlikely(parsed_count == tuple_count)) {
+            return false;
+        }
+        NativeTuple* const tup = tups + parsed_count;
+
+        std::string_view container_id_view;
+        double temp = NAN;
+        // clang-format off
+        if (unlikely(d["id"].get_uint64().get(tup->id) != 0U)) { return false; }
+        if (unlikely(d["timestamp"].get_uint64().get(tup->timestamp) != 0U)) { return false; }
+
+        if (unlikely(d["load"].get_double().get(temp) != 0U)) { return false; }
+        tup->load = static_cast<float>(temp);
+        if (unlikely(d["load_avg_1"].get_double().get(temp) != 0U)) { return false; }
+        tup->load_avg_1 = static_cast<float>(temp);
+        if (unlikely(d["load_avg_5"].get_double().get(temp) != 0U)) { return false; }
+        tup->load_avg_5 = static_cast<float>(temp);
+        if (unlikely(d["load_avg_15"].get_double().get(temp) != 0U)) { return false; }
+        tup->load_avg_15 = static_cast<float>(temp);
+
+        if (unlikely(d["container_id"].get_string().get(container_id_view) != 0U)) { return false; }
+        // clang-format on
+
+        auto result = tup->set_container_id_from_hex_string(
+            container_id_view.data(), container_id_view.data() + container_id_view.size());
+        if (unlikely(result.ec != std::errc() ||
+                     result.ptr != container_id_view.data() + container_id_view.size())) {
+            return false;
+        }
+
+        ++parsed_count;
+    }
+
+    return likely(parsed_count == tuple_count && stream.truncated_bytes() == 0);
+}
+
+template <typename Schema>
+IMPL_VISIBILITY void serialize_json_schema(const typename Schema::Tuple& tup,
+                                           std::vector<std::byte>* buf) {
+    // Layout of serialize_json, one field per line: for NativeTupleSchema, the same bytes.
+    thread_local fmt::memory_buffer local_buffer;
+    local_buffer.clear();
+
+    auto out = std::back_inserter(local_buffer);
+    out = fmt::format_to(out, FMT_COMPILE("{{\n"));
+    Schema::for_each_field([&](auto field, size_t index) {
+        using F = decltype(field);
+        const char* const quote = is_text_field<typename F::value_type> ? "\"" : "";
+        out = fmt::format_to(out, FMT_COMPILE("{}\"{}\": {}"), index == 0 ? "" : ",\n", F::name,
+                             quote);
+        out = format_schema_value(out, F::get(tup));
+        out = fmt::format_to(out, FMT_COMPILE("{}"), quote);
+    });
+    out = fmt::format_to(out, FMT_COMPILE("\n}}\n"));
+    local_buffer.push_back('\0');
+
+    const auto old_size = buf->size();
+    buf->resize(old_size + local_buffer.size());
+    std::copy(begin(local_buffer), end(local_buffer),
+              reinterpret_cast<char*>(buf->data() + old_size));
+}
+
+template <typename Schema>
+IMPL_VISIBILITY bool parse_rapidjson_sax_schema(const std::byte* __restrict__ read_ptr,
+                                                tuple_size_t tup_size,
+                                                typename Schema::Tuple* tup) noexcept {
+    rapidjson::Reader reader;
+    SchemaTupleHandler<Schema> handler{tup};
 
-template void parse_tuples<parse_rapidjson>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-template void parse_tuples<parse_rapidjson_insitu>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-template void parse_tuples<parse_rapidjson_sax>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
+    if (unlikely(read_ptr[tup_size - 1] != std::byte{0b0})) {
+        return false;
+    }
+    rapidjson::StringStream ss(reinterpret_cast<const char*>(read_ptr));
 
-template void parse_tuples<parse_simdjson>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-template void parse_tuples<parse_simdjson_out_of_order>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-template void parse_tuples<parse_simdjson_error_codes>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-template void parse_tuples<parse_simdjson_error_codes_early>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-template void parse_tuples<parse_simdjson_unescaped>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
+    return likely(reader.Parse(ss, handler) != nullptr);
+}
+
+// parse_simdjson_error_codes_early, with the fields of the schema in schema order.
+template <typename Schema>
+IMPL_VISIBILITY bool parse_simdjson_schema(const std::byte* __restrict__ read_ptr,
+                                           tuple_size_t tup_size,
+                                           typename Schema::Tuple* tup) noexcept {
+    static thread_local simdjson::ondemand::parser parser;
+    const simdjson::padded_string_view s(reinterpret_cast<const char*>(read_ptr), tup_size - 1,
+                                         tup_size + simdjson::SIMDJSON_PADDING);
+    simdjson::ondemand::document d;
+    if (unlikely(parser.iterate(s).get(d) != 0U)) {
+        return false;
+    }
+
+    return Schema::all_fields([&](auto field, size_t /*index*/) -> bool {
+        using F = decltype(field);
+        using T = typename F::value_type;
+        T& value = F::get(*tup);
+
+        if constexpr (std::is_same_v<T, uint64_t>) {
+            return likely(d[F::name].get_uint64().get(value) == 0U);
+        } else if constexpr (std::is_same_v<T, float>) {
+            double temp = NAN;
+            if (unlikely(d[F::name].get_double().get(temp) != 0U)) {
+                return false;
+            }
+            value = static_cast<float>(temp);
+            return true;
+        } else {
+            std::string_view view;
+            if (unlikely(d[F::name].get_string().get(view) != 0U)) {
+                return false;
+            }
+            if constexpr (is_inline_string<T>::value) {
+                return value.assign(view);
+            } else {
+                const auto result = parse_hex_bytes(view.data(), view.data() + view.size(), &value);
+                return likely(result.ec == std::errc() && result.ptr == view.data() + view.size());
+            }
+        }
+    });
+}
+
+// clang-format off
+template void generate_tuples<serialize_json>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void generate_tuples<serialize_ndjson>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+
+template void parse_tuples<parse_rapidjson>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_rapidjson_insitu>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_rapidjson_sax>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+template void parse_tuples<parse_simdjson>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_simdjson_out_of_order>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_simdjson_error_codes>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_simdjson_error_codes_early>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_simdjson_unescaped>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_json_fast_path>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuple_batches<parse_simdjson_many>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+template void serialize_tuples<serialize_json>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void serialize_tuples<serialize_ndjson>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_json, parse_rapidjson>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_json, parse_rapidjson_insitu>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_json, parse_rapidjson_sax>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_json, parse_simdjson>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_json, parse_simdjson_out_of_order>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_json, parse_simdjson_error_codes>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_json, parse_simdjson_error_codes_early>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_json, parse_simdjson_unescaped>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_json, parse_json_fast_path>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuple_batches<serialize_ndjson, parse_simdjson_many>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+template void serialize_json_schema<NativeTupleSchema>(const NativeTuple& tup, std::vector<std::byte>* buf);
+template void serialize_json_schema<WideTupleSchema>(const WideTuple& tup, std::vector<std::byte>* buf);
+template void serialize_json_schema<StringTupleSchema>(const StringTuple& tup, std::vector<std::byte>* buf);
+template bool parse_rapidjson_sax_schema<NativeTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
+template bool parse_simdjson_schema<NativeTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
+template bool parse_rapidjson_sax_schema<WideTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, WideTuple* tup) noexcept;
+template bool parse_simdjson_schema<WideTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, WideTuple* tup) noexcept;
+template bool parse_rapidjson_sax_schema<StringTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, StringTuple* tup) noexcept;
+template bool parse_simdjson_schema<StringTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, StringTuple* tup) noexcept;
+
+template void generate_tuples<serialize_json_schema<NativeTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_tuples<parse_rapidjson_sax_schema<NativeTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_simdjson_schema<NativeTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void serialize_tuples<serialize_json_schema<NativeTupleSchema>>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_json_schema<NativeTupleSchema>, parse_rapidjson_sax_schema<NativeTupleSchema>>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_json_schema<NativeTupleSchema>, parse_simdjson_schema<NativeTupleSchema>>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void generate_schema_tuples<WideTupleSchema, serialize_json_schema<WideTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_schema_tuples<WideTupleSchema, parse_rapidjson_sax_schema<WideTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_schema_tuples<WideTupleSchema, parse_simdjson_schema<WideTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void generate_schema_tuples<StringTupleSchema, serialize_json_schema<StringTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_schema_tuples<StringTupleSchema, parse_rapidjson_sax_schema<StringTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_schema_tuples<StringTupleSchema, parse_simdjson_schema<StringTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
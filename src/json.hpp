@@ -3,9 +3,11 @@
 #include <cstddef>
 #include <vector>
 #include "bench.hpp"
+#include "schema.hpp"
 
 // clang-format off
 IMPL_VISIBILITY void serialize_json(const NativeTuple& tup, std::vector<std::byte>* buf);
+IMPL_VISIBILITY void serialize_ndjson(const NativeTuple& tup, std::vector<std::byte>* buf);
 
 IMPL_VISIBILITY bool parse_rapidjson(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
 IMPL_VISIBILITY bool parse_rapidjson_insitu(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
@@ -16,15 +18,60 @@ IMPL_VISIBILITY bool parse_simdjson_out_of_order(const std::byte* __restrict__ r
 IMPL_VISIBILITY bool parse_simdjson_error_codes(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
 IMPL_VISIBILITY bool parse_simdjson_error_codes_early(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
 IMPL_VISIBILITY bool parse_simdjson_unescaped(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup);
+IMPL_VISIBILITY bool parse_json_fast_path(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
+IMPL_VISIBILITY bool parse_simdjson_many(const std::byte* __restrict__ read_ptr, size_t batch_size, size_t tuple_count, const ParseOptions& options, NativeTuple* tups) noexcept;
 
-extern template void generate_tuples<serialize_json>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, std::mutex* mutex);
+extern template void generate_tuples<serialize_json>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void generate_tuples<serialize_ndjson>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
 
-extern template void parse_tuples<parse_rapidjson>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-extern template void parse_tuples<parse_rapidjson_insitu>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-extern template void parse_tuples<parse_rapidjson_sax>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_rapidjson>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_rapidjson_insitu>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_rapidjson_sax>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
 
-extern template void parse_tuples<parse_simdjson>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-extern template void parse_tuples<parse_simdjson_out_of_order>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-extern template void parse_tuples<parse_simdjson_error_codes>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-extern template void parse_tuples<parse_simdjson_error_codes_early>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
-extern template void parse_tuples<parse_simdjson_unescaped>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_simdjson>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_simdjson_out_of_order>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_simdjson_error_codes>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_simdjson_error_codes_early>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_simdjson_unescaped>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_json_fast_path>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuple_batches<parse_simdjson_many>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+extern template void serialize_tuples<serialize_json>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void serialize_tuples<serialize_ndjson>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_json, parse_rapidjson>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_json, parse_rapidjson_insitu>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_json, parse_rapidjson_sax>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_json, parse_simdjson>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_json, parse_simdjson_out_of_order>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_json, parse_simdjson_error_codes>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_json, parse_simdjson_error_codes_early>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_json, parse_simdjson_unescaped>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_json, parse_json_fast_path>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuple_batches<serialize_ndjson, parse_simdjson_many>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+// Serializer and parsers of any schema, see schema.hpp.
+template <typename Schema> IMPL_VISIBILITY void serialize_json_schema(const typename Schema::Tuple& tup, std::vector<std::byte>* buf);
+template <typename Schema> IMPL_VISIBILITY bool parse_rapidjson_sax_schema(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, typename Schema::Tuple* tup) noexcept;
+template <typename Schema> IMPL_VISIBILITY bool parse_simdjson_schema(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, typename Schema::Tuple* tup) noexcept;
+extern template void serialize_json_schema<NativeTupleSchema>(const NativeTuple& tup, std::vector<std::byte>* buf);
+extern template void serialize_json_schema<WideTupleSchema>(const WideTuple& tup, std::vector<std::byte>* buf);
+extern template void serialize_json_schema<StringTupleSchema>(const StringTuple& tup, std::vector<std::byte>* buf);
+extern template bool parse_rapidjson_sax_schema<NativeTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
+extern template bool parse_simdjson_schema<NativeTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
+extern template bool parse_rapidjson_sax_schema<WideTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, WideTuple* tup) noexcept;
+extern template bool parse_simdjson_schema<WideTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, WideTuple* tup) noexcept;
+extern template bool parse_rapidjson_sax_schema<StringTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, StringTuple* tup) noexcept;
+extern template bool parse_simdjson_schema<StringTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, StringTuple* tup) noexcept;
+
+extern template void generate_tuples<serialize_json_schema<NativeTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void parse_tuples<parse_rapidjson_sax_schema<NativeTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_tuples<parse_simdjson_schema<NativeTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void serialize_tuples<serialize_json_schema<NativeTupleSchema>>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_json_schema<NativeTupleSchema>, parse_rapidjson_sax_schema<NativeTupleSchema>>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_json_schema<NativeTupleSchema>, parse_simdjson_schema<NativeTupleSchema>>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void generate_schema_tuples<WideTupleSchema, serialize_json_schema<WideTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void parse_schema_tuples<WideTupleSchema, parse_rapidjson_sax_schema<WideTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_schema_tuples<WideTupleSchema, parse_simdjson_schema<WideTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void generate_schema_tuples<StringTupleSchema, serialize_json_schema<StringTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void parse_schema_tuples<StringTupleSchema, parse_rapidjson_sax_schema<StringTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void parse_schema_tuples<StringTupleSchema, parse_simdjson_schema<StringTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
@@ -0,0 +1,426 @@
+#include <fmt/format.h>
+#include <immintrin.h>
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include "kernels.hpp"
+#include "parse.hpp"
+
+namespace {
+
+/*
+ * Hex strings
+ */
+
+bool decode_hex_scalar(const char* str, size_t byte_count, std::byte* bytes) noexcept {
+    for (size_t i = 0; i < byte_count; ++i) {
+        const char high = str[2 * i];
+        const char low = str[2 * i + 1];
+        if (!is_hex_char(high) || !is_hex_char(low)) {
+            return false;
+        }
+        bytes[i] = static_cast<std::byte>(parse_hex_char(high) * 16 + parse_hex_char(low));
+    }
+    return true;
+}
+
+__attribute__((target("sse4.2"))) bool decode_hex_sse42(const char* str,
+                                                        size_t byte_count,
+                                                        std::byte* bytes) noexcept {
+    size_t i = 0;
+    for (; i + 8 <= byte_count; i += 8) {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + 2 * i));
+        const __m128i digits = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+        const __m128i letters =
+            _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+        const __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letters, _mm_set1_epi8(5)), letters);
+        if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xffff) {
+            return false;
+        }
+
+        const __m128i nibbles =
+            _mm_blendv_epi8(_mm_add_epi8(letters, _mm_set1_epi8(10)), digits, is_digit);
+        // high nibble * 16 + low nibble, one 16-bit word per byte
+        const __m128i words = _mm_maddubs_epi16(nibbles, _mm_set1_epi16(0x0110));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(bytes + i), _mm_packus_epi16(words, words));
+    }
+    return decode_hex_scalar(str + 2 * i, byte_count - i, bytes + i);
+}
+
+__attribute__((target("avx2"))) bool decode_hex_avx2(const char* str,
+                                                     size_t byte_count,
+                                                     std::byte* bytes) noexcept {
+    size_t i = 0;
+    for (; i + 16 <= byte_count; i += 16) {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + 2 * i));
+        const __m256i digits = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+        const __m256i letters =
+            _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+        const __m256i is_digit =
+            _mm256_cmpeq_epi8(_mm256_min_epu8(digits, _mm256_set1_epi8(9)), digits);
+        const __m256i is_letter =
+            _mm256_cmpeq_epi8(_mm256_min_epu8(letters, _mm256_set1_epi8(5)), letters);
+        if (_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter)) != -1) {
+            return false;
+        }
+
+        const __m256i nibbles =
+            _mm256_blendv_epi8(_mm256_add_epi8(letters, _mm256_set1_epi8(10)), digits, is_digit);
+        const __m256i words = _mm256_maddubs_epi16(nibbles, _mm256_set1_epi16(0x0110));
+        // packus works per 128-bit lane: the bytes are in qwords 0 and 2
+        const __m256i packed =
+            _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + i), _mm256_castsi256_si128(packed));
+    }
+    return decode_hex_sse42(str + 2 * i, byte_count - i, bytes + i);
+}
+
+__attribute__((target("avx512f,avx512bw"))) bool decode_hex_avx512(const char* str,
+                                                                   size_t byte_count,
+                                                                   std::byte* bytes) noexcept {
+    size_t i = 0;
+    for (; i + 32 <= byte_count; i += 32) {
+        const __m512i chars = _mm512_loadu_si512(str + 2 * i);
+        const __m512i digits = _mm512_sub_epi8(chars, _mm512_set1_epi8('0'));
+        const __m512i letters =
+            _mm512_sub_epi8(_mm512_or_si512(chars, _mm512_set1_epi8(0x20)), _mm512_set1_epi8('a'));
+        const __mmask64 is_digit = _mm512_cmple_epu8_mask(digits, _mm512_set1_epi8(9));
+        const __mmask64 is_letter = _mm512_cmple_epu8_mask(letters, _mm512_set1_epi8(5));
+        if ((is_digit | is_letter) != ~__mmask64{0}) {
+            return false;
+        }
+
+        const __m512i nibbles = _mm512_mask_blend_epi8(
+            is_digit, _mm512_add_epi8(letters, _mm512_set1_epi8(10)), digits);
+        const __m512i words = _mm512_maddubs_epi16(nibbles, _mm512_set1_epi16(0x0110));
+        // The maskz form: GCC 12 warns about the unset passthrough of _mm512_cvtepi16_epi8.
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(bytes + i),
+                            _mm512_maskz_cvtepi16_epi8(~__mmask32{0}, words));
+    }
+    return decode_hex_avx2(str + 2 * i, byte_count - i, bytes + i);
+}
+
+/*
+ * Decimal integers
+ */
+
+bool parse_uint_digits_scalar(const char* str, size_t len, uint64_t* value) noexcept {
+    if (len - 1 >= 20) {
+        return false;
+    }
+    uint64_t result = 0;
+    for (size_t i = 0; i < len; ++i) {
+        if (str[i] < '0' || str[i] > '9' || __builtin_mul_overflow(result, 10U, &result) ||
+            __builtin_add_overflow(result, static_cast<uint64_t>(str[i] - '0'), &result)) {
+            return false;
+        }
+    }
+    *value = result;
+    return true;
+}
+
+// pshufb masks moving the first n bytes to the end of a 16-byte register, zeroing the others
+constexpr std::array<std::array<int8_t, 16>, 17> right_align_masks = [] {
+    std::array<std::array<int8_t, 16>, 17> masks{};
+    for (size_t n = 0; n <= 16; ++n) {
+        for (size_t i = 0; i < 16; ++i) {
+            masks[n][i] = i >= 16 - n ? static_cast<int8_t>(i - (16 - n)) : int8_t{-128};
+        }
+    }
+    return masks;
+}();
+
+// Also the kernel of the higher levels: the last 16 digits fit one SSE register.
+__attribute__((target("sse4.2"))) bool parse_uint_digits_sse42(const char* str,
+                                                               size_t len,
+                                                               uint64_t* value) noexcept {
+    if (len - 1 >= 20) {
+        return false;
+    }
+
+    // The digits in front of the last 16 are added up one by one.
+    uint64_t high = 0;
+    for (; len > 16; --len, ++str) {
+        if (*str < '0' || *str > '9') {
+            return false;
+        }
+        high = high * 10 + static_cast<uint64_t>(*str - '0');
+    }
+
+    const __m128i digits =
+        _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(str)), _mm_set1_epi8('0'));
+    const __m128i nine = _mm_set1_epi8(9);
+    const auto digit_bits = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(digits, nine), nine)));
+    const uint32_t needed_bits = (uint32_t{1} << len) - 1;
+    if ((digit_bits & needed_bits) != needed_bits) {
+        return false;
+    }
+
+    // Most significant digit first, so the number ends in the last byte.
+    const __m128i aligned = _mm_shuffle_epi8(
+        digits, _mm_loadu_si128(reinterpret_cast<const __m128i*>(right_align_masks[len].data())));
+    const __m128i pairs = _mm_maddubs_epi16(aligned, _mm_set1_epi16(0x010a));  // 8 x 2 digits
+    const __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00010064));   // 4 x 4 digits
+    const __m128i octs = _mm_madd_epi16(_mm_packus_epi32(quads, quads),         // 2 x 8 digits
+                                        _mm_set1_epi32(0x00012710));
+    const uint64_t low = static_cast<uint64_t>(_mm_cvtsi128_si32(octs)) * 100000000 +
+                         static_cast<uint32_t>(_mm_extract_epi32(octs, 1));
+
+    uint64_t result = 0;
+    if (__builtin_mul_overflow(high, uint64_t{10000000000000000}, &result) ||
+        __builtin_add_overflow(result, low, &result)) {
+        return false;
+    }
+    *value = result;
+    return true;
+}
+
+/*
+ * Varint pairs
+ */
+
+bool decode_varint_pair_scalar(uint8_t control, const std::byte* data, uint64_t* values) noexcept {
+    if (control >= 64) {
+        return false;
+    }
+    const size_t first_size = (control & 7U) + 1;
+    const size_t second_size = (control >> 3U) + 1;
+    const auto low_bytes = [](size_t size) {
+        return size == 8 ? ~uint64_t{0} : (uint64_t{1} << (8 * size)) - 1;
+    };
+    uint64_t first = 0;
+    uint64_t second = 0;
+    std::memcpy(&first, data, sizeof(first));
+    std::memcpy(&second, data + first_size, sizeof(second));
+    values[0] = first & low_bytes(first_size);
+    values[1] = second & low_bytes(second_size);
+    return true;
+}
+
+// pshufb masks spreading the two integers of a control byte to the two 64-bit lanes
+constexpr std::array<std::array<int8_t, 16>, 64> varint_pair_masks = [] {
+    std::array<std::array<int8_t, 16>, 64> masks{};
+    for (size_t control = 0; control < 64; ++control) {
+        const size_t first_size = (control & 7U) + 1;
+        const size_t second_size = (control >> 3U) + 1;
+        for (size_t i = 0; i < 8; ++i) {
+            masks[control][i] = i < first_size ? static_cast<int8_t>(i) : int8_t{-128};
+            masks[control][8 + i] =
+                i < second_size ? static_cast<int8_t>(first_size + i) : int8_t{-128};
+        }
+    }
+    return masks;
+}();
+
+// Also the kernel of the higher levels: both integers fit one SSE register.
+__attribute__((target("sse4.2"))) bool decode_varint_pair_sse42(uint8_t control,
+                                                                const std::byte* data,
+                                                                uint64_t* values) noexcept {
+    if (control >= 64) {
+        return false;
+    }
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    const __m128i mask =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(varint_pair_masks[control].data()));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(values), _mm_shuffle_epi8(bytes, mask));
+    return true;
+}
+
+/*
+ * CSV structural index
+ */
+
+bool index_csv_structurals_scalar(const char* str,
+                                  size_t size,
+                                  char delimiter,
+                                  char quote,
+                                  uint32_t* positions,
+                                  size_t* count) noexcept {
+    bool inside_quotes = false;
+    size_t found = 0;
+    for (size_t i = 0; i < size; ++i) {
+        if (str[i] == quote) {
+            inside_quotes = !inside_quotes;
+        } else if (!inside_quotes && (str[i] == delimiter || str[i] == '\n')) {
+            positions[found++] = static_cast<uint32_t>(i);
+        }
+    }
+    *count = found;
+    return !inside_quotes;
+}
+
+// Appends the structurals of the 64-byte block at offset that are outside quotes. Bit i of quotes
+// and structurals stands for str[offset + i].
+__attribute__((target("pclmul"), always_inline)) inline size_t append_block_structurals(
+    uint64_t quotes,
+    uint64_t structurals,
+    size_t offset,
+    size_t size,
+    uint64_t* inside_quotes,  // all ones while the previous block ended inside quotes
+    uint32_t* positions,
+    size_t found) {
+    // bytes past the end belong to the next batch (or padding) and must not flip the state
+    const uint64_t valid =
+        size - offset < 64 ? (uint64_t{1} << (size - offset)) - 1 : ~uint64_t{0};
+    // prefix xor: bit i is set inside quoted regions, including the opening quote
+    const uint64_t quoted =
+        static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_clmulepi64_si128(
+            _mm_set_epi64x(0, static_cast<int64_t>(quotes & valid)), _mm_set1_epi8(-1), 0))) ^
+        *inside_quotes;
+    *inside_quotes = static_cast<uint64_t>(static_cast<int64_t>(quoted) >> 63U);
+
+    structurals &= ~quoted & valid;
+    while (structurals != 0) {
+        positions[found++] = static_cast<uint32_t>(offset + std::countr_zero(structurals));
+        structurals &= structurals - 1;
+    }
+    return found;
+}
+
+__attribute__((target("sse4.2,pclmul"))) bool index_csv_structurals_sse42(
+    const char* str,
+    size_t size,
+    char delimiter,
+    char quote,
+    uint32_t* positions,
+    size_t* count) noexcept {
+    const __m128i quote_needle = _mm_set1_epi8(quote);
+    const __m128i delimiter_needle = _mm_set1_epi8(delimiter);
+    const __m128i newline_needle = _mm_set1_epi8('\n');
+    uint64_t inside_quotes = 0;
+    size_t found = 0;
+    for (size_t offset = 0; offset < size; offset += 64) {
+        uint64_t quotes = 0;
+        uint64_t structurals = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            const __m128i chunk =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + offset + 16 * i));
+            const auto chunk_quotes =
+                static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote_needle)));
+            const auto chunk_structurals = static_cast<uint16_t>(
+                _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, delimiter_needle),
+                                               _mm_cmpeq_epi8(chunk, newline_needle))));
+            quotes |= static_cast<uint64_t>(chunk_quotes) << (16 * i);
+            structurals |= static_cast<uint64_t>(chunk_structurals) << (16 * i);
+        }
+        found = append_block_structurals(quotes, structurals, offset, size, &inside_quotes,
+                                         positions, found);
+    }
+    *count = found;
+    return inside_quotes == 0;
+}
+
+__attribute__((target("avx2,pclmul"))) bool index_csv_structurals_avx2(const char* str,
+                                                                       size_t size,
+                                                                       char delimiter,
+                                                                       char quote,
+                                                                       uint32_t* positions,
+                                                                       size_t* count) noexcept {
+    const __m256i quote_needle = _mm256_set1_epi8(quote);
+    const __m256i delimiter_needle = _mm256_set1_epi8(delimiter);
+    const __m256i newline_needle = _mm256_set1_epi8('\n');
+    uint64_t inside_quotes = 0;
+    size_t found = 0;
+    for (size_t offset = 0; offset < size; offset += 64) {
+        uint64_t quotes = 0;
+        uint64_t structurals = 0;
+        for (size_t i = 0; i < 2; ++i) {
+            const __m256i chunk =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + offset + 32 * i));
+            const auto chunk_quotes = static_cast<uint32_t>(
+                _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote_needle)));
+            const auto chunk_structurals = static_cast<uint32_t>(
+                _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, delimiter_needle),
+                                                     _mm256_cmpeq_epi8(chunk, newline_needle))));
+            quotes |= static_cast<uint64_t>(chunk_quotes) << (32 * i);
+            structurals |= static_cast<uint64_t>(chunk_structurals) << (32 * i);
+        }
+        found = append_block_structurals(quotes, structurals, offset, size, &inside_quotes,
+                                         positions, found);
+    }
+    *count = found;
+    return inside_quotes == 0;
+}
+
+__attribute__((target("avx512f,avx512bw,pclmul"))) bool index_csv_structurals_avx512(
+    const char* str,
+    size_t size,
+    char delimiter,
+    char quote,
+    uint32_t* positions,
+    size_t* count) noexcept {
+    const __m512i quote_needle = _mm512_set1_epi8(quote);
+    const __m512i delimiter_needle = _mm512_set1_epi8(delimiter);
+    const __m512i newline_needle = _mm512_set1_epi8('\n');
+    uint64_t inside_quotes = 0;
+    size_t found = 0;
+    for (size_t offset = 0; offset < size; offset += 64) {
+        const __m512i block = _mm512_loadu_si512(str + offset);
+        const uint64_t quotes = _mm512_cmpeq_epi8_mask(block, quote_needle);
+        const uint64_t structurals = _mm512_cmpeq_epi8_mask(block, delimiter_needle) |
+                                     _mm512_cmpeq_epi8_mask(block, newline_needle);
+        found = append_block_structurals(quotes, structurals, offset, size, &inside_quotes,
+                                         positions, found);
+    }
+    *count = found;
+    return inside_quotes == 0;
+}
+
+// indexed by Isa
+constexpr std::array<Kernels, 4> kernel_levels{
+    Kernels{Isa::scalar, decode_hex_scalar, parse_uint_digits_scalar,
+            index_csv_structurals_scalar, decode_varint_pair_scalar},
+    Kernels{Isa::sse42, decode_hex_sse42, parse_uint_digits_sse42, index_csv_structurals_sse42,
+            decode_varint_pair_sse42},
+    Kernels{Isa::avx2, decode_hex_avx2, parse_uint_digits_sse42, index_csv_structurals_avx2,
+            decode_varint_pair_sse42},
+    Kernels{Isa::avx512, decode_hex_avx512, parse_uint_digits_sse42,
+            index_csv_structurals_avx512, decode_varint_pair_sse42},
+};
+
+}  // namespace
+
+Kernels kernels = kernel_levels[static_cast<size_t>(detect_isa())];
+
+Isa detect_isa() noexcept {
+    // Also checks that the OS saves the AVX and AVX-512 registers.
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("sse4.2") || !__builtin_cpu_supports("pclmul")) {
+        return Isa::scalar;
+    }
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        return Isa::avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return Isa::avx2;
+    }
+    return Isa::sse42;
+}
+
+std::string_view isa_name(Isa isa) noexcept {
+    switch (isa) {
+        case Isa::scalar:
+            return "scalar";
+        case Isa::sse42:
+            return "sse4.2";
+        case Isa::avx2:
+            return "avx2";
+        case Isa::avx512:
+            return "avx512";
+    }
+    return "unknown";
+}
+
+void select_kernels(Isa isa) {
+    const Isa supported = detect_isa();
+    if (isa > supported) {
+        throw std::runtime_error(fmt::format("{} kernels are not supported by this CPU (up to {})",
+                                             isa_name(isa), isa_name(supported)));
+    }
+    kernels = kernel_levels[static_cast<size_t>(isa)];
+}
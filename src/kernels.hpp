@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Hot parsing kernels with one implementation per instruction set level, chosen at startup from
+// cpuid. The binary itself only needs the baseline of BENCH_MARCH, every level above is compiled
+// with target attributes.
+
+// Every level includes the ones below it.
+enum class Isa {
+    scalar,
+    sse42,   // SSE4.2 and PCLMUL
+    avx2,    // AVX2 and PCLMUL
+    avx512,  // AVX-512 F and BW, and PCLMUL
+};
+
+struct Kernels {
+    Isa isa;
+
+    // Decodes the 2 * byte_count hex digits at str into bytes. False if one is not a hex digit.
+    bool (*decode_hex)(const char* str, size_t byte_count, std::byte* bytes) noexcept;
+
+    // Parses the `len` decimal digits at str, 1 to 20 of them. False if one is not a digit or the
+    // value does not fit. Reads 16 bytes from str.
+    bool (*parse_uint_digits)(const char* str, size_t len, uint64_t* value) noexcept;
+
+    // Stores the offsets of all delimiters and newlines in [str, str + size) outside quotes to
+    // positions, which has room for `size` of them, and their number to count. Reads up to 63
+    // bytes past the end (covered by MEMORY_PADDING). False if the input ends inside quotes.
+    bool (*index_csv_structurals)(const char* str,
+                                  size_t size,
+                                  char delimiter,
+                                  char quote,
+                                  uint32_t* positions,
+                                  size_t* count) noexcept;
+
+    // Decodes the two little-endian integers at data to values[0] and values[1]. Their sizes
+    // minus one, 0 to 7, are bits 0-2 and 3-5 of control, bits 6-7 must be zero. Reads 16 bytes
+    // from data.
+    bool (*decode_varint_pair)(uint8_t control, const std::byte* data, uint64_t* values) noexcept;
+};
+
+// Kernels of the highest level the CPU supports, until select_kernels switches them.
+extern Kernels kernels;
+
+// Highest level the CPU and the OS support.
+[[nodiscard]] Isa detect_isa() noexcept;
+
+[[nodiscard]] std::string_view isa_name(Isa isa) noexcept;
+
+// Switches `kernels` to the implementations of isa. Throws std::runtime_error if the CPU does not
+// support it. Must not run concurrently with parser threads.
+void select_kernels(Isa isa);
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <x86intrin.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+// Reads the TSC before the measured code: lfence keeps earlier instructions from still running.
+inline uint64_t tsc_begin() {
+    _mm_lfence();
+    const uint64_t tsc = __rdtsc();
+    _mm_lfence();
+    return tsc;
+}
+
+// Reads the TSC after the measured code: rdtscp waits for all earlier instructions, lfence keeps
+// later ones from starting before the read.
+inline uint64_t tsc_end() {
+    unsigned int aux = 0;
+    const uint64_t tsc = __rdtscp(&aux);
+    _mm_lfence();
+    return tsc;
+}
+
+// TSC ticks per nanosecond, measured against the steady clock.
+inline double estimate_tsc_ticks_per_ns() {
+    const auto clock_start = std::chrono::steady_clock::now();
+    const uint64_t tsc_start = tsc_begin();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    const uint64_t tsc_stop = tsc_end();
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - clock_start;
+    return static_cast<double>(tsc_stop - tsc_start) / elapsed.count();
+}
+
+// Smallest difference of two back-to-back tsc_begin()/tsc_end() calls, included in every sample.
+inline uint64_t estimate_tsc_overhead() {
+    uint64_t overhead = std::numeric_limits<uint64_t>::max();
+    for (size_t i = 0; i < 1000; ++i) {
+        const uint64_t start = tsc_begin();
+        overhead = std::min(overhead, tsc_end() - start);
+    }
+    return overhead;
+}
+
+// Log-linear histogram in the style of HdrHistogram: every power of two range is split into
+// LINEAR_BUCKETS buckets, so values are kept with a relative error below 1 / LINEAR_BUCKETS over
+// the whole uint64_t range in a fixed ~15 KiB array. Not thread safe, every thread records into
+// its own histogram and they are merged afterwards.
+class LatencyHistogram {
+   public:
+    static constexpr size_t LINEAR_BITS = 5;
+    static constexpr size_t LINEAR_BUCKETS = size_t{1} << LINEAR_BITS;
+    static constexpr size_t BUCKET_COUNT = (64 - LINEAR_BITS + 1) * LINEAR_BUCKETS;
+
+    void record(uint64_t value) {
+        ++counts_[bucket_index(value)];
+        ++count_;
+        max_ = std::max(max_, value);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        count_ += other.count_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    [[nodiscard]] uint64_t count() const { return count_; }
+    [[nodiscard]] uint64_t max() const { return max_; }
+
+    // Upper bound of the bucket holding the value at `quantile` (0..1), never more than max().
+    [[nodiscard]] uint64_t value_at_quantile(double quantile) const {
+        const auto rank = static_cast<uint64_t>(quantile * static_cast<double>(count_));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += counts_[i];
+            if (seen > rank) {
+                return std::min(bucket_upper_bound(i), max_);
+            }
+        }
+        return max_;
+    }
+
+    static constexpr size_t bucket_index(uint64_t value) {
+        if (value < 2 * LINEAR_BUCKETS) {
+            return value;
+        }
+        const size_t shift = std::bit_width(value) - 1 - LINEAR_BITS;
+        return (shift + 1) * LINEAR_BUCKETS + ((value >> shift) - LINEAR_BUCKETS);
+    }
+
+    static constexpr uint64_t bucket_upper_bound(size_t index) {
+        if (index < 2 * LINEAR_BUCKETS) {
+            return index;
+        }
+        const size_t shift = index / LINEAR_BUCKETS - 1;
+        const uint64_t lower = (index % LINEAR_BUCKETS + LINEAR_BUCKETS) << shift;
+        return lower + ((uint64_t{1} << shift) - 1);
+    }
+
+   private:
+    std::array<uint64_t, BUCKET_COUNT> counts_{};
+    uint64_t count_ = 0;
+    uint64_t max_ = 0;
+};
+
+static_assert(LatencyHistogram::bucket_index(std::numeric_limits<uint64_t>::max()) ==
+              LatencyHistogram::BUCKET_COUNT - 1);
+static_assert(LatencyHistogram::bucket_index(2 * LatencyHistogram::LINEAR_BUCKETS) ==
+              2 * LatencyHistogram::LINEAR_BUCKETS);
@@ -0,0 +1,432 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+#include "bench.hpp"
+#include "msgpack.hpp"
+
+using namespace std::literals::string_view_literals;
+
+namespace {
+
+// Keys of the map serialize_msgpack writes, in this order.
+constexpr std::array<std::string_view, 7> msgpack_keys{
+    "id"sv,         "timestamp"sv,   "load"sv,        "load_avg_1"sv,
+    "load_avg_5"sv, "load_avg_15"sv, "container_id"sv,
+};
+
+// Nesting of arrays and maps MsgpackReader::skip follows in unknown fields.
+constexpr size_t msgpack_max_depth = 16;
+
+std::byte* write_msgpack_uint(uint64_t value, std::byte* out) {
+    // the shortest encoding, as every msgpack encoder is supposed to use
+    if (value < 0x80) {
+        out[0] = static_cast<std::byte>(value);
+        return out + 1;
+    }
+    if (value <= UINT8_MAX) {
+        out[0] = std::byte{0xcc};
+        out[1] = static_cast<std::byte>(value);
+        return out + 2;
+    }
+    if (value <= UINT16_MAX) {
+        out[0] = std::byte{0xcd};
+        store_big_endian(static_cast<uint16_t>(value), out + 1);
+        return out + 3;
+    }
+    if (value <= UINT32_MAX) {
+        out[0] = std::byte{0xce};
+        store_big_endian(static_cast<uint32_t>(value), out + 1);
+        return out + 5;
+    }
+    out[0] = std::byte{0xcf};
+    store_big_endian(value, out + 1);
+    return out + 9;
+}
+
+std::byte* write_msgpack_key(std::string_view key, std::byte* out) {
+    // fixstr, all keys are shorter than 32 bytes
+    out[0] = static_cast<std::byte>(0xa0U | key.size());
+    std::memcpy(out + 1, key.data(), key.size());
+    return out + 1 + key.size();
+}
+
+std::byte* write_msgpack_float(float value, std::byte* out) {
+    out[0] = std::byte{0xca};
+    store_big_endian(std::bit_cast<uint32_t>(value), out + 1);
+    return out + 5;
+}
+
+// Bounds-checked reads of msgpack values, in any of their encodings.
+class MsgpackReader {
+   public:
+    MsgpackReader(const std::byte* ptr, const std::byte* end) : ptr_(ptr), end_(end) {}
+
+    [[nodiscard]] bool at_end() const { return ptr_ == end_; }
+
+    // True and consumed if the next byte is `byte`.
+    [[nodiscard]] bool expect_byte(uint8_t byte) {
+        if (unlikely(ptr_ == end_ || *ptr_ != std::byte{byte})) {
+            return false;
+        }
+        ++ptr_;
+        return true;
+    }
+
+    // True and consumed if the next value is `key` as a fixstr.
+    [[nodiscard]] bool expect_key(std::string_view key) {
+        if (unlikely(static_cast<size_t>(end_ - ptr_) < 1 + key.size() ||
+                     *ptr_ != static_cast<std::byte>(0xa0U | key.size()) ||
+                     std::memcmp(ptr_ + 1, key.data(), key.size()) != 0)) {
+            return false;
+        }
+        ptr_ += 1 + key.size();
+        return true;
+    }
+
+    [[nodiscard]] bool read_map_size(size_t* size) {
+        uint8_t type = 0;
+        if (unlikely(!read_type(&type))) {
+            return false;
+        }
+        if ((type & 0xf0U) == 0x80) {
+            *size = type & 0x0fU;
+            return true;
+        }
+        switch (type) {
+            case 0xde:
+                return read_length<uint16_t>(size);
+            case 0xdf:
+                return read_length<uint32_t>(size);
+            default:
+                return false;
+        }
+    }
+
+    [[nodiscard]] bool read_str(std::string_view* str) {
+        uint8_t type = 0;
+        size_t size = 0;
+        if (unlikely(!read_type(&type))) {
+            return false;
+        }
+        if ((type & 0xe0U) == 0xa0) {
+            size = type & 0x1fU;
+        } else if (!((type == 0xd9 && read_length<uint8_t>(&size)) ||
+                     (type == 0xda && read_length<uint16_t>(&size)) ||
+                     (type == 0xdb && read_length<uint32_t>(&size)))) {
+            return false;
+        }
+        const std::byte* data = nullptr;
+        if (unlikely(!read_bytes(size, &data))) {
+            return false;
+        }
+        *str = std::string_view(reinterpret_cast<const char*>(data), size);
+        return true;
+    }
+
+    [[nodiscard]] bool read_bin(std::span<const std::byte>* bytes) {
+        uint8_t type = 0;
+        size_t size = 0;
+        if (unlikely(!read_type(&type) || !((type == 0xc4 && read_length<uint8_t>(&size)) ||
+                                            (type == 0xc5 && read_length<uint16_t>(&size)) ||
+                                            (type == 0xc6 && read_length<uint32_t>(&size))))) {
+            return false;
+        }
+        const std::byte* data = nullptr;
+        if (unlikely(!read_bytes(size, &data))) {
+            return false;
+        }
+        *bytes = std::span(data, size);
+        return true;
+    }
+
+    // Also accepts the signed types, which some encoders use for every integer, if not negative.
+    [[nodiscard]] bool read_uint(uint64_t* value) {
+        uint8_t type = 0;
+        if (unlikely(!read_type(&type))) {
+            return false;
+        }
+        if (type < 0x80) {
+            *value = type;
+            return true;
+        }
+        switch (type) {
+            case 0xcc:
+                return read_number<uint8_t>(value);
+            case 0xcd:
+                return read_number<uint16_t>(value);
+            case 0xce:
+                return read_number<uint32_t>(value);
+            case 0xcf:
+                return read_number<uint64_t>(value);
+            case 0xd0:
+                return read_number<uint8_t>(value) && *value < 0x80;
+            case 0xd1:
+                return read_number<uint16_t>(value) && *value < 0x8000;
+            case 0xd2:
+                return read_number<uint32_t>(value) && *value < 0x80000000;
+            case 0xd3:
+                return read_number<uint64_t>(value) && *value < (uint64_t{1} << 63U);
+            default:
+                return false;
+        }
+    }
+
+    [[nodiscard]] bool read_float(float* value) {
+        uint8_t type = 0;
+        uint64_t bits = 0;
+        if (unlikely(!read_type(&type))) {
+            return false;
+        }
+        switch (type) {
+            case 0xca:
+                if (unlikely(!read_number<uint32_t>(&bits))) {
+                    return false;
+                }
+                *value = std::bit_cast<float>(static_cast<uint32_t>(bits));
+                return true;
+            case 0xcb:
+                if (unlikely(!read_number<uint64_t>(&bits))) {
+                    return false;
+                }
+                *value = static_cast<float>(std::bit_cast<double>(bits));
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Skips one value of any type, e.g. of a field NativeTuple does not have.
+    [[nodiscard]] bool skip(size_t depth = 0) {
+        uint8_t type = 0;
+        size_t size = 0;
+        if (unlikely(depth > msgpack_max_depth || !read_type(&type))) {
+            return false;
+        }
+        if (type < 0x80 || type >= 0xe0) {  // fixints
+            return true;
+        }
+        if (type < 0x90) {
+            return skip_values(2 * (type & 0x0fU), depth);
+        }
+        if (type < 0xa0) {
+            return skip_values(type & 0x0fU, depth);
+        }
+        if (type < 0xc0) {
+            return skip_bytes(type & 0x1fU);
+        }
+        switch (type) {
+            case 0xc0:  // nil
+            case 0xc2:  // false
+            case 0xc3:  // true
+                return true;
+            case 0xc4:
+            case 0xd9:
+                return read_length<uint8_t>(&size) && skip_bytes(size);
+            case 0xc5:
+            case 0xda:
+                return read_length<uint16_t>(&size) && skip_bytes(size);
+            case 0xc6:
+            case 0xdb:
+                return read_length<uint32_t>(&size) && skip_bytes(size);
+            case 0xc7:  // ext: length, type, data
+                return read_length<uint8_t>(&size) && skip_bytes(size + 1);
+            case 0xc8:
+                return read_length<uint16_t>(&size) && skip_bytes(size + 1);
+            case 0xc9:
+                return read_length<uint32_t>(&size) && skip_bytes(size + 1);
+            case 0xca:
+            case 0xce:
+            case 0xd2:
+                return skip_bytes(4);
+            case 0xcb:
+            case 0xcf:
+            case 0xd3:
+                return skip_bytes(8);
+            case 0xcc:
+            case 0xd0:
+                return skip_bytes(1);
+            case 0xcd:
+            case 0xd1:
+                return skip_bytes(2);
+            case 0xd4:  // fixext: type and 1, 2, 4, 8 or 16 bytes
+                return skip_bytes(2);
+            case 0xd5:
+                return skip_bytes(3);
+            case 0xd6:
+                return skip_bytes(5);
+            case 0xd7:
+                return skip_bytes(9);
+            case 0xd8:
+                return skip_bytes(17);
+            case 0xdc:
+                return read_length<uint16_t>(&size) && skip_values(size, depth);
+            case 0xdd:
+                return read_length<uint32_t>(&size) && skip_values(size, depth);
+            case 0xde:
+                return read_length<uint16_t>(&size) && skip_values(2 * size, depth);
+            case 0xdf:
+                return read_length<uint32_t>(&size) && skip_values(2 * size, depth);
+            default:  // 0xc1 is never used
+                return false;
+        }
+    }
+
+   private:
+    bool read_type(uint8_t* type) {
+        if (unlikely(ptr_ == end_)) {
+            return false;
+        }
+        *type = static_cast<uint8_t>(*ptr_++);
+        return true;
+    }
+
+    template <typename T>
+    bool read_number(uint64_t* value) {
+        if (unlikely(static_cast<size_t>(end_ - ptr_) < sizeof(T))) {
+            return false;
+        }
+        *value = load_big_endian<T>(ptr_);
+        ptr_ += sizeof(T);
+        return true;
+    }
+
+    template <typename T>
+    bool read_length(size_t* size) {
+        uint64_t value = 0;
+        if (unlikely(!read_number<T>(&value))) {
+            return false;
+        }
+        *size = value;
+        return true;
+    }
+
+    bool read_bytes(size_t size, const std::byte** data) {
+        *data = ptr_;
+        return skip_bytes(size);
+    }
+
+    bool skip_bytes(size_t size) {
+        if (unlikely(static_cast<size_t>(end_ - ptr_) < size)) {
+            return false;
+        }
+        ptr_ += size;
+        return true;
+    }
+
+    bool skip_values(size_t count, size_t depth) {
+        // every value is at least one byte, malformed counts fail at the end of the input
+        for (size_t i = 0; i < count; ++i) {
+            if (unlikely(!skip(depth + 1))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const std::byte* ptr_;
+    const std::byte* end_;
+};
+
+}  // namespace
+
+IMPL_VISIBILITY void serialize_msgpack(const NativeTuple& tup, std::vector<std::byte>* buf) {
+    // A map from field names to values, like the json formats.
+    constexpr size_t max_tuple_size = 160;
+    const size_t old_size = buf->size();
+    buf->resize(old_size + max_tuple_size);
+    std::byte* out = buf->data() + old_size;
+
+    *out++ = static_cast<std::byte>(0x80U | msgpack_keys.size());  // fixmap
+    out = write_msgpack_uint(tup.id, write_msgpack_key(msgpack_keys[0], out));
+    out = write_msgpack_uint(tup.timestamp, write_msgpack_key(msgpack_keys[1], out));
+    out = write_msgpack_float(tup.load, write_msgpack_key(msgpack_keys[2], out));
+    out = write_msgpack_float(tup.load_avg_1, write_msgpack_key(msgpack_keys[3], out));
+    out = write_msgpack_float(tup.load_avg_5, write_msgpack_key(msgpack_keys[4], out));
+    out = write_msgpack_float(tup.load_avg_15, write_msgpack_key(msgpack_keys[5], out));
+    out = write_msgpack_key(msgpack_keys[6], out);
+    *out++ = std::byte{0xc4};  // bin 8
+    *out++ = std::byte{HASH_BYTES};
+    out = std::copy(tup.container_id.begin(), tup.container_id.end(), out);
+
+    buf->resize(static_cast<size_t>(out - buf->data()));
+}
+
+IMPL_VISIBILITY bool parse_msgpack(const std::byte* __restrict__ read_ptr,
+                                   tuple_size_t tup_size,
+                                   NativeTuple* tup) noexcept {
+    // Walks the map like a generic decoder: fields in any order and encoding, unknown ones skipped.
+    MsgpackReader reader(read_ptr, read_ptr + tup_size);
+    size_t field_count = 0;
+    if (unlikely(!reader.read_map_size(&field_count))) {
+        return false;
+    }
+
+    uint32_t fields_seen = 0;  // bit i: msgpack_keys[i]
+    for (size_t i = 0; i < field_count; ++i) {
+        std::string_view key;
+        if (unlikely(!reader.read_str(&key))) {
+            return false;
+        }
+
+        bool success = false;
+        std::span<const std::byte> container_id;
+        // clang-format off
+        if (key == "id"sv) { success = reader.read_uint(&tup->id); fields_seen |= 1U << 0U;
+        } else if (key == "timestamp"sv) { success = reader.read_uint(&tup->timestamp); fields_seen |= 1U << 1U;
+        } else if (key == "load"sv) { success = reader.read_float(&tup->load); fields_seen |= 1U << 2U;
+        } else if (key == "load_avg_1"sv) { success = reader.read_float(&tup->load_avg_1); fields_seen |= 1U << 3U;
+        } else if (key == "load_avg_5"sv) { success = reader.read_float(&tup->load_avg_5); fields_seen |= 1U << 4U;
+        } else if (key == "load_avg_15"sv) { success = reader.read_float(&tup->load_avg_15); fields_seen |= 1U << 5U;
+        } else if (key == "container_id"sv) {
+            success = reader.read_bin(&container_id) && container_id.size() == HASH_BYTES;
+            if (likely(success)) { std::copy(container_id.begin(), container_id.end(), tup->container_id.begin()); }
+            fields_seen |= 1U << 6U;
+        } else { success = reader.skip(); }
+        // clang-format on
+        if (unlikely(!success)) {
+            return false;
+        }
+    }
+    return likely(fields_seen == (1U << msgpack_keys.size()) - 1 && reader.at_end());
+}
+
+IMPL_VISIBILITY bool parse_msgpack_fast(const std::byte* __restrict__ read_ptr,
+                                        tuple_size_t tup_size,
+                                        NativeTuple* tup) noexcept {
+    // Expects the map exactly like serialize_msgpack writes it: the keys in this order, compared as
+    // a whole, and binary container ids. Integer and float widths may vary. Anything else goes to
+    // parse_msgpack.
+    MsgpackReader reader(read_ptr, read_ptr + tup_size);
+    std::span<const std::byte> container_id;
+    // clang-format off
+    if (likely(reader.expect_byte(0x80 | msgpack_keys.size()) &&
+               reader.expect_key(msgpack_keys[0]) && reader.read_uint(&tup->id) &&
+               reader.expect_key(msgpack_keys[1]) && reader.read_uint(&tup->timestamp) &&
+               reader.expect_key(msgpack_keys[2]) && reader.read_float(&tup->load) &&
+               reader.expect_key(msgpack_keys[3]) && reader.read_float(&tup->load_avg_1) &&
+               reader.expect_key(msgpack_keys[4]) && reader.read_float(&tup->load_avg_5) &&
+               reader.expect_key(msgpack_keys[5]) && reader.read_float(&tup->load_avg_15) &&
+               reader.expect_key(msgpack_keys[6]) && reader.read_bin(&container_id) &&
+               container_id.size() == HASH_BYTES && reader.at_end())) {
+        std::copy(container_id.begin(), container_id.end(), tup->container_id.begin());
+        return true;
+    }
+    // clang-format on
+
+    ++thread_fallback_tuples;
+    return parse_msgpack(read_ptr, tup_size, tup);
+}
+
+// clang-format off
+template void generate_tuples<serialize_msgpack>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_tuples<parse_msgpack>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void parse_tuples<parse_msgpack_fast>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+template void serialize_tuples<serialize_msgpack>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_msgpack, parse_msgpack>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_msgpack, parse_msgpack_fast>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
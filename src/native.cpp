@@ -5,6 +5,7 @@
 
 #include "bench.hpp"
 #include "native.hpp"
+#include "schema.hpp"
 
 IMPL_VISIBILITY void serialize_native(const NativeTuple& tup, std::vector<std::byte>* buf) {
     const size_t write_index = buf->size();
@@ -24,11 +25,55 @@ IMPL_VISIBILITY bool parse_native(const std::byte* __restrict__ read_ptr,
     return true;
 }
 
+template <typename Schema>
+IMPL_VISIBILITY void serialize_native_schema(const typename Schema::Tuple& tup,
+                                             std::vector<std::byte>* buf) {
+    using Tuple = typename Schema::Tuple;
+    const size_t write_index = buf->size();
+    buf->resize(buf->size() + sizeof(Tuple));
+    auto* const write_ptr = buf->data() + write_index;
+    std::copy_n(reinterpret_cast<const std::byte*>(&tup), sizeof(Tuple), write_ptr);
+}
+
+template <typename Schema>
+IMPL_VISIBILITY bool parse_native_schema(const std::byte* __restrict__ read_ptr,
+                                         tuple_size_t tup_size,
+                                         typename Schema::Tuple* tup) noexcept {
+    using Tuple = typename Schema::Tuple;
+    if (unlikely((tup_size != sizeof(Tuple)))) {
+        return false;
+    }
+
+    *tup = *reinterpret_cast<const Tuple*>(read_ptr);
+    return true;
+}
+
 template void generate_tuples<serialize_native>(std::vector<std::byte>* memory,
                                                 size_t target_memory_size,
                                                 std::vector<tuple_size_t>* tuple_sizes,
-                                                std::mutex* mutex);
+                                                const GeneratorOptions& options);
 template void parse_tuples<parse_native>(ThreadResult* result,
-                                         const std::vector<std::byte>& memory,
-                                         const std::vector<tuple_size_t>& tuple_sizes,
+                                         const DatasetView& dataset,
+                                         const ParseOptions& options,
                                          const std::atomic<bool>& stop_flag);
+
+template void serialize_tuples<serialize_native>(ThreadResult* result,
+                                                 std::span<const NativeTuple> tuples,
+                                                 const ParseOptions& options,
+                                                 const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_native, parse_native>(
+    ThreadResult* result,
+    std::span<const NativeTuple> tuples,
+    const ParseOptions& options,
+    const std::atomic<bool>& stop_flag);
+
+// clang-format off
+template void serialize_native_schema<WideTupleSchema>(const WideTuple& tup, std::vector<std::byte>* buf);
+template void serialize_native_schema<StringTupleSchema>(const StringTuple& tup, std::vector<std::byte>* buf);
+template bool parse_native_schema<WideTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, WideTuple* tup) noexcept;
+template bool parse_native_schema<StringTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, StringTuple* tup) noexcept;
+
+template void generate_schema_tuples<WideTupleSchema, serialize_native_schema<WideTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_schema_tuples<WideTupleSchema, parse_native_schema<WideTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void generate_schema_tuples<StringTupleSchema, serialize_native_schema<StringTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_schema_tuples<StringTupleSchema, parse_native_schema<StringTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
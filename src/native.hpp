@@ -3,10 +3,28 @@
 #include <cstddef>
 #include <vector>
 #include "bench.hpp"
+#include "schema.hpp"
 
 // clang-format off
 IMPL_VISIBILITY void serialize_native(const NativeTuple& tup, std::vector<std::byte>* buf);
 IMPL_VISIBILITY bool parse_native(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, NativeTuple* tup) noexcept;
 
-extern template void generate_tuples<serialize_native>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, std::mutex* mutex);
-extern template void parse_tuples<parse_native>(ThreadResult* result, const std::vector<std::byte>& memory, const std::vector<tuple_size_t>& tuple_sizes, const std::atomic<bool>& stop_flag);
+extern template void generate_tuples<serialize_native>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void parse_tuples<parse_native>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+extern template void serialize_tuples<serialize_native>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void roundtrip_tuples<serialize_native, parse_native>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+// Serializer and parser of any schema, see schema.hpp. For NativeTupleSchema, these are
+// serialize_native and parse_native.
+template <typename Schema> IMPL_VISIBILITY void serialize_native_schema(const typename Schema::Tuple& tup, std::vector<std::byte>* buf);
+template <typename Schema> IMPL_VISIBILITY bool parse_native_schema(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, typename Schema::Tuple* tup) noexcept;
+extern template void serialize_native_schema<WideTupleSchema>(const WideTuple& tup, std::vector<std::byte>* buf);
+extern template void serialize_native_schema<StringTupleSchema>(const StringTuple& tup, std::vector<std::byte>* buf);
+extern template bool parse_native_schema<WideTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, WideTuple* tup) noexcept;
+extern template bool parse_native_schema<StringTupleSchema>(const std::byte* __restrict__ read_ptr, tuple_size_t tup_size, StringTuple* tup) noexcept;
+
+extern template void generate_schema_tuples<WideTupleSchema, serialize_native_schema<WideTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void parse_schema_tuples<WideTupleSchema, parse_native_schema<WideTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+extern template void generate_schema_tuples<StringTupleSchema, serialize_native_schema<StringTupleSchema>>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+extern template void parse_schema_tuples<StringTupleSchema, parse_native_schema<StringTupleSchema>>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
@@ -1,17 +1,21 @@
 #pragma once
 
+#include <bit>
 #include <charconv>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 #include "constants.hpp"
 
 constexpr inline bool is_hex_char(char c) {
-    return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || ('0' <= c && c <= '9');
+    return ('a' <= c && c <= 'f') || ('A' <= c && c <= 'F') || ('0' <= c && c <= '9');
 }
 
 constexpr inline unsigned char parse_hex_char(char c) {
-    return (static_cast<int>('a' <= c && c <= 'z') * (c - 'a' + 10) +
-            static_cast<int>('A' <= c && c <= 'Z') * (c - 'A' + 10) +
+    return (static_cast<int>('a' <= c && c <= 'f') * (c - 'a' + 10) +
+            static_cast<int>('A' <= c && c <= 'F') * (c - 'A' + 10) +
             static_cast<int>('0' <= c && c <= '9') * (c - '0'));
 }
 
@@ -29,3 +33,24 @@ constexpr inline std::from_chars_result parse_uint_str(const char* str,
     }
     return {str, std::errc()};
 }
+
+// Big-endian integers of the binary formats (msgpack, cbor). May be unaligned.
+template <typename T>
+[[nodiscard]] inline T load_big_endian(const std::byte* ptr) {
+    static_assert(std::is_unsigned_v<T>);
+    T value;
+    std::memcpy(&value, ptr, sizeof(T));
+    if constexpr (std::endian::native == std::endian::little && sizeof(T) > 1) {
+        value = static_cast<T>(__builtin_bswap64(value) >> (64 - 8 * sizeof(T)));
+    }
+    return value;
+}
+
+template <typename T>
+inline void store_big_endian(T value, std::byte* ptr) {
+    static_assert(std::is_unsigned_v<T>);
+    if constexpr (std::endian::native == std::endian::little && sizeof(T) > 1) {
+        value = static_cast<T>(__builtin_bswap64(value) >> (64 - 8 * sizeof(T)));
+    }
+    std::memcpy(ptr, &value, sizeof(T));
+}
@@ -0,0 +1,138 @@
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <utility>
+#include <vector>
+
+#include "perf.hpp"
+
+namespace {
+
+struct EventConfig {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t hw_cache_config(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8U) | (result << 16U);
+}
+
+// same order as PerfEvent
+constexpr std::array<EventConfig, PERF_EVENT_COUNT> event_configs{{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, hw_cache_config(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                         PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, hw_cache_config(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                                         PERF_COUNT_HW_CACHE_RESULT_MISS)},
+}};
+
+int perf_event_open(perf_event_attr* attr, int group_fd) {
+    // pid 0, cpu -1: the calling thread on any CPU
+    return static_cast<int>(syscall(SYS_perf_event_open, attr, 0, -1, group_fd, 0));
+}
+
+}  // namespace
+
+std::string_view perf_event_name(PerfEvent event) {
+    constexpr std::array<std::string_view, PERF_EVENT_COUNT> names{
+        "cycles", "instructions", "L1D misses", "LLC misses", "branch misses", "dTLB misses",
+    };
+    return names[static_cast<size_t>(event)];
+}
+
+PerfCounts& PerfCounts::operator+=(const PerfCounts& other) {
+    for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        if (values[i] && other.values[i]) {
+            *values[i] += *other.values[i];
+        } else {
+            values[i].reset();
+        }
+    }
+    return *this;
+}
+
+PerfCounterGroup PerfCounterGroup::open_for_current_thread() {
+    PerfCounterGroup group;
+    for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = event_configs[i].type;
+        attr.config = event_configs[i].config;
+        attr.disabled = i == 0 ? 1 : 0;  // members follow the leader
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format =
+            PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        group.fds_[i] = perf_event_open(&attr, i == 0 ? -1 : group.fds_[0]);
+        if (i == 0 && group.fds_[0] < 0) {
+            return group;
+        }
+    }
+    return group;
+}
+
+PerfCounterGroup::~PerfCounterGroup() {
+    for (const int fd : fds_) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+PerfCounterGroup::PerfCounterGroup(PerfCounterGroup&& other) noexcept
+    : fds_(std::exchange(other.fds_, {-1, -1, -1, -1, -1, -1})) {}
+
+PerfCounterGroup& PerfCounterGroup::operator=(PerfCounterGroup&& other) noexcept {
+    std::swap(fds_, other.fds_);
+    return *this;
+}
+
+void PerfCounterGroup::enable() const {
+    if (available()) {
+        ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+void PerfCounterGroup::disable() const {
+    if (available()) {
+        ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+PerfCounts PerfCounterGroup::read() const {
+    PerfCounts counts;
+    if (!available()) {
+        return counts;
+    }
+
+    // struct read_format { nr, time_enabled, time_running, values[nr] }
+    std::vector<uint64_t> buffer(3 + PERF_EVENT_COUNT);
+    const auto bytes = ::read(fds_[0], buffer.data(), buffer.size() * sizeof(uint64_t));
+    if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+        return counts;
+    }
+    const uint64_t time_enabled = buffer[1];
+    const uint64_t time_running = buffer[2];
+    if (time_running == 0) {
+        return counts;
+    }
+    const double scale = static_cast<double>(time_enabled) / static_cast<double>(time_running);
+
+    // Values are in the order the members were added, skipping the ones that failed to open.
+    size_t value_index = 3;
+    for (size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        if (fds_[i] < 0) {
+            continue;
+        }
+        counts.values[i] = static_cast<uint64_t>(static_cast<double>(buffer[value_index]) * scale);
+        ++value_index;
+    }
+    return counts;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// Hardware events counted per parser thread during the measurement.
+enum class PerfEvent : size_t {
+    cycles,
+    instructions,
+    l1d_misses,
+    llc_misses,
+    branch_misses,
+    dtlb_misses,
+};
+constexpr size_t PERF_EVENT_COUNT = 6;
+
+std::string_view perf_event_name(PerfEvent event);
+
+// Event values, scaled up if the kernel had to multiplex the group. Events that could not be
+// opened on this machine are empty.
+struct PerfCounts {
+    std::array<std::optional<uint64_t>, PERF_EVENT_COUNT> values{};
+
+    [[nodiscard]] const std::optional<uint64_t>& operator[](PerfEvent event) const {
+        return values[static_cast<size_t>(event)];
+    }
+    PerfCounts& operator+=(const PerfCounts& other);
+};
+
+// One perf_event_open group counting the user space events of the thread that opened it. The group
+// starts disabled. Other threads may enable, disable and read it, the file descriptors belong to
+// the process.
+class PerfCounterGroup {
+   public:
+    PerfCounterGroup() = default;
+    ~PerfCounterGroup();
+
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+    PerfCounterGroup(PerfCounterGroup&& other) noexcept;
+    PerfCounterGroup& operator=(PerfCounterGroup&& other) noexcept;
+
+    static PerfCounterGroup open_for_current_thread();
+
+    // False if not even the cycle counter could be opened, e.g. in containers or with
+    // kernel.perf_event_paranoid > 2.
+    [[nodiscard]] bool available() const { return fds_[0] >= 0; }
+
+    void enable() const;
+    void disable() const;
+    [[nodiscard]] PerfCounts read() const;
+
+   private:
+    std::array<int, PERF_EVENT_COUNT> fds_{-1, -1, -1, -1, -1, -1};
+};
@@ -0,0 +1,275 @@
+#include <fmt/format.h>
+#include <simdjson.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <string_view>
+
+#include "results.hpp"
+
+namespace {
+
+std::string json_escape(std::string_view str) {
+    std::string escaped;
+    escaped.reserve(str.size() + 2);
+    escaped += '"';
+    for (const char c : str) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += fmt::format("\\u{:04x}", static_cast<int>(c));
+        } else {
+            escaped += c;
+        }
+    }
+    escaped += '"';
+    return escaped;
+}
+
+// Quotes fields with a delimiter, quote or line break (RFC 4180), e.g. a --pin list like 0,2,4-7.
+std::string csv_escape(std::string_view str) {
+    if (str.find_first_of(",\"\r\n") == std::string_view::npos) {
+        return std::string(str);
+    }
+    std::string escaped;
+    escaped.reserve(str.size() + 2);
+    escaped += '"';
+    for (const char c : str) {
+        if (c == '"') {
+            escaped += '"';
+        }
+        escaped += c;
+    }
+    escaped += '"';
+    return escaped;
+}
+
+std::string json_number(double value) {
+    // JSON has no representation for inf or nan, e.g. the error of a single sample
+    return std::isfinite(value) ? fmt::format("{}", value) : "null";
+}
+
+std::string format_value(const ConfigValue& value, bool quote_strings) {
+    return std::visit(
+        [&](const auto& v) -> std::string {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, std::string>) {
+                return quote_strings ? json_escape(v) : v;
+            } else if constexpr (std::is_same_v<T, double>) {
+                return json_number(v);
+            } else {
+                return fmt::format("{}", v);
+            }
+        },
+        value);
+}
+
+std::string json_summary(const std::vector<double>& samples) {
+    const auto [mean, stddev, error] = mean_stddev_99error_from_samples(samples);
+    return fmt::format(R"({{"mean": {}, "stddev": {}, "error99": {}}})", json_number(mean),
+                       json_number(stddev), json_number(error));
+}
+
+std::string json_array(const std::vector<double>& values) {
+    std::vector<std::string> numbers;
+    numbers.reserve(values.size());
+    for (const double value : values) {
+        numbers.push_back(json_number(value));
+    }
+    return fmt::format("[{}]", fmt::join(numbers, ", "));
+}
+
+struct ComparedRun {
+    double mean;
+    double error;
+};
+
+std::map<std::string, ComparedRun> load_results(simdjson::dom::parser* parser,
+                                                const std::string& path) {
+    std::map<std::string, ComparedRun> runs;
+    try {
+        const simdjson::dom::element root = parser->load(path);
+        for (const simdjson::dom::element run : root["runs"].get_array()) {
+            std::vector<std::string> key_parts;
+            for (const auto field : run["config"].get_object()) {
+                if (field.key == "seed") {
+                    continue;
+                }
+                key_parts.push_back(fmt::format("{}={}", field.key, simdjson::minify(field.value)));
+            }
+            const auto summary = run["summary"]["tuples_per_second"];
+            runs[fmt::format("{}", fmt::join(key_parts, " "))] = {
+                summary["mean"].get_double(), summary["error99"].is_null()
+                                                  ? 0.0
+                                                  : static_cast<double>(summary["error99"])};
+        }
+    } catch (const simdjson::simdjson_error& e) {
+        throw std::runtime_error(fmt::format("Could not read results from {}: {}", path, e.what()));
+    }
+    return runs;
+}
+
+}  // namespace
+
+std::tuple<double, double, double> mean_stddev_99error_from_samples(
+    const std::vector<double>& samples) {
+    const double sum = std::accumulate(begin(samples), end(samples), 0.0);
+    const double mean = sum / static_cast<double>(samples.size());
+
+    const double squared_error_sum =
+        std::accumulate(begin(samples), end(samples), 0.0, [&](double acc, double sample) {
+            return acc + (sample - mean) * (sample - mean);
+        });
+
+    const double variance = squared_error_sum / static_cast<double>(samples.size() - 1);
+    const double std_dev = sqrt(variance);
+
+    // 99% => z* = 2.58
+    const double error = 2.58 * std_dev / sqrt(static_cast<double>(samples.size()));
+
+    return std::make_tuple(mean, std_dev, error);
+}
+
+void print_comparison_table(std::FILE* out, const std::vector<RunResult>& runs) {
+    if (runs.empty()) {
+        return;
+    }
+
+    std::vector<size_t> columns;
+    for (size_t i = 0; i < runs.front().config.size(); ++i) {
+        const auto& [name, value] = runs.front().config[i];
+        const bool differs = std::any_of(begin(runs), end(runs), [&](const RunResult& run) {
+            return i >= run.config.size() || run.config[i].second != value;
+        });
+        if (differs && name != "seed") {
+            columns.push_back(i);
+        }
+    }
+
+    std::vector<double> means;
+    for (const RunResult& run : runs) {
+        means.push_back(std::get<0>(mean_stddev_99error_from_samples(run.tuples_per_second)));
+    }
+    const double best = *std::max_element(begin(means), end(means));
+
+    for (const size_t column : columns) {
+        fmt::print(out, "{:>20} ", runs.front().config[column].first);
+    }
+    fmt::print(out, "{:>12} {:>9} {:>10} {:>8}\n", "t/s", "99% err", "GB/s", "of best");
+    for (size_t run_index = 0; run_index < runs.size(); ++run_index) {
+        const RunResult& run = runs[run_index];
+        for (const size_t column : columns) {
+            fmt::print(out, "{:>20} ", column < run.config.size()
+                                           ? format_value(run.config[column].second, false)
+                                           : "");
+        }
+        const auto [tuples_mean, tuples_stddev, tuples_error] =
+            mean_stddev_99error_from_samples(run.tuples_per_second);
+        const double bytes_mean =
+            std::get<0>(mean_stddev_99error_from_samples(run.bytes_per_second));
+        fmt::print(out, "{:>12.6g} {:>8.3f}% {:>10.4g} {:>7.2f}%\n", tuples_mean,
+                   tuples_error / tuples_mean * 100, bytes_mean / 1e9,
+                   tuples_mean / best * 100);
+    }
+}
+
+void write_results_json(std::FILE* out, const std::vector<RunResult>& runs) {
+    fmt::print(out, "{{\n  \"runs\": [");
+    for (size_t run_index = 0; run_index < runs.size(); ++run_index) {
+        const RunResult& run = runs[run_index];
+
+        std::vector<std::string> config;
+        for (const auto& [name, value] : run.config) {
+            config.push_back(fmt::format("{}: {}", json_escape(name), format_value(value, true)));
+        }
+        std::vector<std::string> metrics;
+        for (const auto& [name, value] : run.metrics) {
+            metrics.push_back(fmt::format("{}: {}", json_escape(name), json_number(value)));
+        }
+
+        fmt::print(out, "{}\n    {{\n", run_index == 0 ? "" : ",");
+        fmt::print(out, "      \"config\": {{{}}},\n", fmt::join(config, ", "));
+        fmt::print(out,
+                   "      \"samples\": {{\"tuples_per_second\": {}, \"bytes_per_second\": {}}},\n",
+                   json_array(run.tuples_per_second), json_array(run.bytes_per_second));
+        fmt::print(out,
+                   "      \"summary\": {{\"tuples_per_second\": {}, \"bytes_per_second\": {}}},\n",
+                   json_summary(run.tuples_per_second), json_summary(run.bytes_per_second));
+        fmt::print(out, "      \"metrics\": {{{}}}\n    }}", fmt::join(metrics, ", "));
+    }
+    fmt::print(out, "\n  ]\n}}\n");
+}
+
+void write_results_csv(std::FILE* out, const std::vector<RunResult>& runs) {
+    if (runs.empty()) {
+        return;
+    }
+
+    std::vector<std::string> header;
+    for (const auto& [name, value] : runs.front().config) {
+        header.push_back(csv_escape(name));
+    }
+    fmt::print(out, "{},kind,index,tuples_per_second,bytes_per_second\n", fmt::join(header, ","));
+
+    for (const RunResult& run : runs) {
+        std::vector<std::string> config;
+        for (const auto& [name, value] : run.config) {
+            config.push_back(csv_escape(format_value(value, false)));
+        }
+        const std::string prefix = fmt::format("{}", fmt::join(config, ","));
+
+        for (size_t i = 0; i < run.tuples_per_second.size(); ++i) {
+            fmt::print(out, "{},sample,{},{},{}\n", prefix, i, run.tuples_per_second[i],
+                       run.bytes_per_second[i]);
+        }
+        const auto [tuples_mean, tuples_stddev, tuples_error] =
+            mean_stddev_99error_from_samples(run.tuples_per_second);
+        const auto [bytes_mean, bytes_stddev, bytes_error] =
+            mean_stddev_99error_from_samples(run.bytes_per_second);
+        fmt::print(out, "{},mean,,{},{}\n", prefix, tuples_mean, bytes_mean);
+        fmt::print(out, "{},stddev,,{},{}\n", prefix, tuples_stddev, bytes_stddev);
+        fmt::print(out, "{},error99,,{},{}\n", prefix, tuples_error, bytes_error);
+        for (const auto& [name, value] : run.metrics) {
+            fmt::print(out, "{},{},,{},\n", prefix, csv_escape(name), value);
+        }
+    }
+}
+
+size_t compare_results(const std::string& baseline_path, const std::string& candidate_path) {
+    simdjson::dom::parser parser;
+    const auto baseline = load_results(&parser, baseline_path);
+    const auto candidate = load_results(&parser, candidate_path);
+
+    size_t regressions = 0;
+    fmt::print("{:>14} {:>14} {:>8}  {:<11}  {}\n", "baseline t/s", "candidate t/s", "change",
+               "verdict", "run");
+    for (const auto& [key, base] : baseline) {
+        const auto it = candidate.find(key);
+        if (it == candidate.end()) {
+            fmt::print("{:>14.6g} {:>14} {:>8}  {:<11}  {}\n", base.mean, "-", "-", "missing", key);
+            continue;
+        }
+        const ComparedRun& cand = it->second;
+
+        // Only call it a change if the 99% confidence intervals are disjoint.
+        std::string_view verdict = "unchanged";
+        if (cand.mean + cand.error < base.mean - base.error) {
+            verdict = "REGRESSION";
+            ++regressions;
+        } else if (cand.mean - cand.error > base.mean + base.error) {
+            verdict = "improvement";
+        }
+        fmt::print("{:>14.6g} {:>14.6g} {:>+7.2f}%  {:<11}  {}\n", base.mean, cand.mean,
+                   (cand.mean / base.mean - 1) * 100, verdict, key);
+    }
+    for (const auto& [key, cand] : candidate) {
+        if (baseline.count(key) == 0) {
+            fmt::print("{:>14} {:>14.6g} {:>8}  {:<11}  {}\n", "-", cand.mean, "-", "new", key);
+        }
+    }
+    return regressions;
+}
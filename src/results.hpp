@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+std::tuple<double, double, double> mean_stddev_99error_from_samples(
+    const std::vector<double>& samples);
+
+using ConfigValue = std::variant<std::string, uint64_t, double>;
+
+// Everything one measurement produced, in a form that can be written as JSON or CSV.
+struct RunResult {
+    // Settings that influence the numbers. Runs with equal config (ignoring the seed) are compared
+    // against each other by --compare.
+    std::vector<std::pair<std::string, ConfigValue>> config;
+    // one sample per measured second
+    std::vector<double> tuples_per_second;
+    std::vector<double> bytes_per_second;
+    // Further summary values like latency percentiles or perf counters.
+    std::vector<std::pair<std::string, double>> metrics;
+};
+
+// Mean throughput of every run next to each other. Only config entries that differ between the
+// runs are shown.
+void print_comparison_table(std::FILE* out, const std::vector<RunResult>& runs);
+
+// {"runs": [{"config": {...}, "samples": {...}, "summary": {...}, "metrics": {...}}, ...]}
+void write_results_json(std::FILE* out, const std::vector<RunResult>& runs);
+
+// One row per sample and per summary statistic, the config columns of the first run as header.
+void write_results_csv(std::FILE* out, const std::vector<RunResult>& runs);
+
+// Compares the tuple throughput of all runs with equal keys in two JSON result files. A change is
+// significant if the 99% confidence intervals do not overlap. Returns the number of significant
+// regressions, throws std::runtime_error for unreadable files.
+size_t compare_results(const std::string& baseline_path, const std::string& candidate_path);
@@ -0,0 +1,429 @@
+#pragma once
+
+#include <fmt/compile.h>
+#include <fmt/format.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "bench.hpp"
+
+// Compile-time tuple layouts. A schema lists the fields of a tuple struct by name and member; the
+// native, csv and json serializers and parsers of schema tuples are instantiated from that list
+// (native.cpp, csv.cpp, json.cpp), so a layout is written down exactly once.
+//
+// Field types: uint64_t, float, InlineString<N> (text without ',', '"', '\\' and control
+// characters, so csv and json need no quoting or escaping) and std::array<std::byte, N> (2N hex
+// characters).
+
+// String literal as template argument.
+template <size_t N>
+struct FieldName {
+    // NOLINTNEXTLINE(google-explicit-constructor, hicpp-explicit-conversions)
+    constexpr FieldName(const char (&str)[N]) { std::copy_n(str, N, chars.begin()); }
+
+    [[nodiscard]] constexpr std::string_view view() const { return {chars.data(), N - 1}; }
+
+    std::array<char, N> chars{};
+};
+
+// Text of up to N characters, stored in the tuple.
+template <size_t N>
+struct InlineString {
+    static_assert(N < 256);
+
+    uint8_t size = 0;
+    std::array<char, N> chars{};
+
+    [[nodiscard]] std::string_view view() const { return {chars.data(), size}; }
+
+    [[nodiscard]] bool assign(std::string_view str) {
+        if (unlikely(str.size() > N)) {
+            return false;
+        }
+        size = static_cast<uint8_t>(str.size());
+        std::copy(str.begin(), str.end(), chars.begin());
+        return true;
+    }
+};
+
+template <typename T>
+struct is_inline_string : std::false_type {};
+template <size_t N>
+struct is_inline_string<InlineString<N>> : std::true_type {};
+
+template <typename T>
+struct is_byte_array : std::false_type {};
+template <size_t N>
+struct is_byte_array<std::array<std::byte, N>> : std::true_type {};
+
+// What generate_schema_tuple draws for a uint64_t field.
+enum class FieldRole {
+    value,      // uniform over 64 bits, log-uniform magnitudes in the other workloads
+    id,         // the workload's ids
+    timestamp,  // the workload's timestamps
+};
+
+template <typename MemberPointer>
+struct member_pointer_traits;
+template <typename Class, typename Value>
+struct member_pointer_traits<Value Class::*> {
+    using class_type = Class;
+    using value_type = Value;
+};
+
+template <FieldName Name, auto Member, FieldRole Role = FieldRole::value>
+struct Field {
+    using tuple_type = typename member_pointer_traits<decltype(Member)>::class_type;
+    using value_type = typename member_pointer_traits<decltype(Member)>::value_type;
+    static constexpr std::string_view name = Name.view();
+    static constexpr FieldRole role = Role;
+
+    template <typename Tuple>
+    static constexpr auto& get(Tuple& tup) {  // NOLINT(runtime/references)
+        return tup.*Member;
+    }
+};
+
+// Characters of generated strings: 6 bits each, so one random number yields 10 of them.
+constexpr std::string_view INLINE_STRING_ALPHABET =
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_";
+constexpr size_t CHARS_PER_RANDOM_NUMBER = 10;
+static_assert(INLINE_STRING_ALPHABET.size() == 64);
+
+template <typename T>
+constexpr uint64_t random_numbers_for_field() {
+    if constexpr (std::is_same_v<T, uint64_t> || std::is_same_v<T, float>) {
+        return 1;
+    } else if constexpr (is_inline_string<T>::value) {
+        // length, then the characters
+        return 1 + (std::tuple_size_v<decltype(T::chars)> + CHARS_PER_RANDOM_NUMBER - 1) /
+                       CHARS_PER_RANDOM_NUMBER;
+    } else if constexpr (is_byte_array<T>::value) {
+        return (std::tuple_size_v<T> + 7) / 8;
+    } else {
+        static_assert(sizeof(T) == 0, "unsupported field type");
+    }
+}
+
+template <typename TupleT, typename... Fields>
+struct Schema {
+    using Tuple = TupleT;
+    static_assert(std::is_trivially_copyable_v<Tuple>);
+    static_assert((std::is_same_v<typename Fields::tuple_type, Tuple> && ...));
+
+    static constexpr size_t field_count = sizeof...(Fields);
+    // every tuple draws this many numbers from its own part of the random stream
+    static constexpr uint64_t random_numbers_per_tuple =
+        (random_numbers_for_field<typename Fields::value_type>() + ...);
+
+    // Calls f(Field{}, index) for every field in order.
+    template <typename F>
+    static constexpr void for_each_field(F&& f) {
+        size_t index = 0;
+        (f(Fields{}, index++), ...);
+    }
+
+    // Calls f(Field{}, index) for every field in order while it returns true.
+    template <typename F>
+    static constexpr bool all_fields(F&& f) {
+        size_t index = 0;
+        return (f(Fields{}, index++) && ...);
+    }
+
+    // Calls f(Field{}) for field number `index`. False if f does or there is no such field.
+    template <typename F>
+    static bool visit_field(size_t index, F&& f) {
+        size_t i = 0;
+        return ((i++ == index && f(Fields{})) || ...);
+    }
+
+    // Index of the field called `name`, field_count if there is none.
+    static size_t field_index(std::string_view name) {
+        size_t index = 0;
+        (void)((Fields::name != name && (++index, true)) && ...);
+        return index;
+    }
+};
+
+/*
+ * Predefined schemas
+ */
+
+// The tuple all other formats use.
+using NativeTupleSchema = Schema<NativeTuple,
+                                 Field<"id", &NativeTuple::id, FieldRole::id>,
+                                 Field<"timestamp", &NativeTuple::timestamp, FieldRole::timestamp>,
+                                 Field<"load", &NativeTuple::load>,
+                                 Field<"load_avg_1", &NativeTuple::load_avg_1>,
+                                 Field<"load_avg_5", &NativeTuple::load_avg_5>,
+                                 Field<"load_avg_15", &NativeTuple::load_avg_15>,
+                                 Field<"container_id", &NativeTuple::container_id>>;
+
+// 30 numeric fields, closer to the width of real monitoring records.
+struct WideTuple {
+    uint64_t id;
+    uint64_t timestamp;
+    float load;
+    float load_avg_1;
+    float load_avg_5;
+    float load_avg_15;
+    uint64_t cpu_user_ns;
+    uint64_t cpu_system_ns;
+    uint64_t cpu_throttled_ns;
+    uint64_t memory_rss_bytes;
+    uint64_t memory_cache_bytes;
+    uint64_t memory_swap_bytes;
+    uint64_t network_rx_bytes;
+    uint64_t network_tx_bytes;
+    uint64_t network_rx_packets;
+    uint64_t network_tx_packets;
+    uint64_t disk_read_bytes;
+    uint64_t disk_write_bytes;
+    float cpu_percent;
+    float memory_percent;
+    float network_rx_errors_percent;
+    float network_tx_errors_percent;
+    float disk_read_latency_ms;
+    float disk_write_latency_ms;
+    float disk_utilization_percent;
+    float gpu_percent;
+    float gpu_memory_percent;
+    float temperature_celsius;
+    float power_watts;
+    std::array<std::byte, HASH_BYTES> container_id;
+};
+
+using WideTupleSchema =
+    Schema<WideTuple,
+           Field<"id", &WideTuple::id, FieldRole::id>,
+           Field<"timestamp", &WideTuple::timestamp, FieldRole::timestamp>,
+           Field<"load", &WideTuple::load>,
+           Field<"load_avg_1", &WideTuple::load_avg_1>,
+           Field<"load_avg_5", &WideTuple::load_avg_5>,
+           Field<"load_avg_15", &WideTuple::load_avg_15>,
+           Field<"cpu_user_ns", &WideTuple::cpu_user_ns>,
+           Field<"cpu_system_ns", &WideTuple::cpu_system_ns>,
+           Field<"cpu_throttled_ns", &WideTuple::cpu_throttled_ns>,
+           Field<"memory_rss_bytes", &WideTuple::memory_rss_bytes>,
+           Field<"memory_cache_bytes", &WideTuple::memory_cache_bytes>,
+           Field<"memory_swap_bytes", &WideTuple::memory_swap_bytes>,
+           Field<"network_rx_bytes", &WideTuple::network_rx_bytes>,
+           Field<"network_tx_bytes", &WideTuple::network_tx_bytes>,
+           Field<"network_rx_packets", &WideTuple::network_rx_packets>,
+           Field<"network_tx_packets", &WideTuple::network_tx_packets>,
+           Field<"disk_read_bytes", &WideTuple::disk_read_bytes>,
+           Field<"disk_write_bytes", &WideTuple::disk_write_bytes>,
+           Field<"cpu_percent", &WideTuple::cpu_percent>,
+           Field<"memory_percent", &WideTuple::memory_percent>,
+           Field<"network_rx_errors_percent", &WideTuple::network_rx_errors_percent>,
+           Field<"network_tx_errors_percent", &WideTuple::network_tx_errors_percent>,
+           Field<"disk_read_latency_ms", &WideTuple::disk_read_latency_ms>,
+           Field<"disk_write_latency_ms", &WideTuple::disk_write_latency_ms>,
+           Field<"disk_utilization_percent", &WideTuple::disk_utilization_percent>,
+           Field<"gpu_percent", &WideTuple::gpu_percent>,
+           Field<"gpu_memory_percent", &WideTuple::gpu_memory_percent>,
+           Field<"temperature_celsius", &WideTuple::temperature_celsius>,
+           Field<"power_watts", &WideTuple::power_watts>,
+           Field<"container_id", &WideTuple::container_id>>;
+static_assert(WideTupleSchema::field_count == 30);
+
+// Mostly text: container metadata as it arrives with every sample.
+struct StringTuple {
+    uint64_t id;
+    uint64_t timestamp;
+    InlineString<32> hostname;
+    InlineString<64> container_name;
+    InlineString<96> image;
+    InlineString<32> namespace_name;
+    InlineString<16> region;
+    InlineString<16> status;
+    InlineString<128> command;
+    InlineString<64> labels;
+    float load;
+    std::array<std::byte, HASH_BYTES> container_id;
+};
+
+using StringTupleSchema =
+    Schema<StringTuple,
+           Field<"id", &StringTuple::id, FieldRole::id>,
+           Field<"timestamp", &StringTuple::timestamp, FieldRole::timestamp>,
+           Field<"hostname", &StringTuple::hostname>,
+           Field<"container_name", &StringTuple::container_name>,
+           Field<"image", &StringTuple::image>,
+           Field<"namespace", &StringTuple::namespace_name>,
+           Field<"region", &StringTuple::region>,
+           Field<"status", &StringTuple::status>,
+           Field<"command", &StringTuple::command>,
+           Field<"labels", &StringTuple::labels>,
+           Field<"load", &StringTuple::load>,
+           Field<"container_id", &StringTuple::container_id>>;
+
+/*
+ * Generation and text output
+ */
+
+// Tuple number tuple_index of the stream of `seed`. Strings are between half and all of their
+// capacity long.
+template <typename Schema>
+typename Schema::Tuple generate_schema_tuple(uint64_t seed,
+                                             uint64_t tuple_index,
+                                             const WorkloadProfile& profile) {
+    CounterRng gen(seed, tuple_index * Schema::random_numbers_per_tuple);
+    typename Schema::Tuple tup;
+    // also the padding, which the native format copies to the dataset
+    std::memset(static_cast<void*>(&tup), 0, sizeof(tup));
+
+    Schema::for_each_field([&](auto field, size_t /*index*/) {
+        using F = decltype(field);
+        using T = typename F::value_type;
+        T& value = F::get(tup);
+
+        if constexpr (std::is_same_v<T, uint64_t>) {
+            const uint64_t draw = gen();
+            if constexpr (F::role == FieldRole::id) {
+                value = profile_id(profile.ids, draw, tuple_index);
+            } else if constexpr (F::role == FieldRole::timestamp) {
+                value = profile_timestamp(profile.timestamps, draw, tuple_index);
+            } else {
+                value = profile.ids == IdDistribution::uniform ? draw : draw >> (draw & 63U);
+            }
+        } else if constexpr (std::is_same_v<T, float>) {
+            const double unit = static_cast<double>(gen()) / static_cast<double>(CounterRng::max());
+            value = static_cast<float>(profile.loads == LoadDistribution::unit ? unit : unit * 100);
+            value = profile_round(profile.floats, value);
+        } else if constexpr (is_inline_string<T>::value) {
+            constexpr size_t capacity = std::tuple_size_v<decltype(T::chars)>;
+            value.size = static_cast<uint8_t>(capacity / 2 + gen() % (capacity - capacity / 2 + 1));
+            for (size_t i = 0; i < capacity; i += CHARS_PER_RANDOM_NUMBER) {
+                uint64_t draw = gen();
+                for (size_t j = i; j < std::min(i + CHARS_PER_RANDOM_NUMBER, capacity); ++j) {
+                    value.chars[j] = INLINE_STRING_ALPHABET[draw & 63U];
+                    draw >>= 6U;
+                }
+            }
+            // what a parser leaves there, so parsed tuples compare equal to generated ones
+            std::fill(value.chars.begin() + value.size, value.chars.end(), '\0');
+        } else if constexpr (is_byte_array<T>::value) {
+            for (size_t i = 0; i < value.size(); i += 8) {
+                const uint64_t draw = gen();
+                std::copy_n(reinterpret_cast<const std::byte*>(&draw),
+                            std::min<size_t>(8, value.size() - i), value.data() + i);
+            }
+        }
+    });
+    return tup;
+}
+
+// Appends the text of a field value, as csv and json print it (without json's quotes).
+template <typename OutputIt, typename T>
+OutputIt format_schema_value(OutputIt out, const T& value) {
+    if constexpr (std::is_same_v<T, uint64_t>) {
+        return fmt::format_to(out, FMT_COMPILE("{}"), value);
+    } else if constexpr (std::is_same_v<T, float>) {
+        return fmt::format_to(out, FMT_COMPILE("{}"), TextFloat{value});
+    } else if constexpr (is_inline_string<T>::value) {
+        return std::copy(value.view().begin(), value.view().end(), out);
+    } else if constexpr (is_byte_array<T>::value) {
+        return fmt::format_to(out, FMT_COMPILE("{:02x}"), fmt::join(value, ""));
+    } else {
+        static_assert(sizeof(T) == 0, "unsupported field type");
+    }
+}
+
+template <typename T>
+constexpr bool is_text_field = is_inline_string<T>::value || is_byte_array<T>::value;
+
+/*
+ * Benchmark runners for schemas other than NativeTupleSchema
+ *
+ * Parsers of NativeTupleSchema produce NativeTuples and use the runners of bench.hpp with all
+ * their modes. Other schemas only get plain parse runs into the discard or aos sink.
+ */
+
+template <typename Schema>
+using SchemaSerializerFunc = void (*)(const typename Schema::Tuple&, std::vector<std::byte>*);
+template <typename Schema>
+using SchemaParseFunc = bool (*)(const std::byte*, tuple_size_t, typename Schema::Tuple*);
+
+template <typename Schema, SchemaSerializerFunc<Schema> serialize>
+void generate_schema_tuples(std::vector<std::byte>* memory,
+                            size_t target_memory_size,
+                            std::vector<tuple_size_t>* tuple_sizes,
+                            const GeneratorOptions& options) {
+    generate_dataset(memory, target_memory_size, tuple_sizes, options,
+                     [&](uint64_t tuple_index, std::vector<std::byte>* buf) {
+                         serialize(generate_schema_tuple<Schema>(options.seed, tuple_index,
+                                                                 options.profile),
+                                   buf);
+                     });
+}
+
+template <typename Schema, SchemaParseFunc<Schema> parse, bool store_rows>
+void parse_schema_tuples_into(ThreadResult* result,
+                              const DatasetView& dataset,
+                              const std::atomic<bool>& stop_flag) {
+    using Tuple = typename Schema::Tuple;
+    const std::byte* const start_ptr = dataset.memory.data();
+    const std::byte* read_ptr = start_ptr;
+    size_t tuple_index = 0;
+    const size_t tuple_count = dataset.tuple_sizes.size();
+    std::vector<Tuple> rows(store_rows ? RUN_SIZE : 0);
+
+    while (!stop_flag.load(std::memory_order_relaxed)) {
+        size_t total_bytes_read = 0;
+
+        for (size_t i = 0; i < RUN_SIZE; ++i) {
+            if (tuple_index == tuple_count) {
+                read_ptr = start_ptr;
+                tuple_index = 0;
+            }
+
+            const tuple_size_t tup_size = dataset.tuple_sizes[tuple_index];
+
+            Tuple tup{};
+            bool success = false;
+            try {
+                success = parse(read_ptr, tup_size, &tup);
+            } catch (...) {
+                success = false;
+            }
+            if (unlikely(!success)) {
+                fmt::print("Invalid input tuple dropped\n");
+                exit(1);  // NOLINT(concurrency-mt-unsafe)
+            }
+            if constexpr (store_rows) {
+                rows[i] = tup;
+            } else {
+                DoNotOptimize(tup);
+            }
+
+            read_ptr += tup_size;
+            ++tuple_index;
+            total_bytes_read += tup_size;
+        }
+        DoNotOptimize(rows.data());
+
+        result->tuples_read += RUN_SIZE;
+        result->bytes_read += total_bytes_read;
+    }
+}
+
+template <typename Schema, SchemaParseFunc<Schema> parse>
+void parse_schema_tuples(ThreadResult* result,
+                         const DatasetView& dataset,
+                         const ParseOptions& options,
+                         const std::atomic<bool>& stop_flag) {
+    if (options.sink == OutputSink::discard) {
+        parse_schema_tuples_into<Schema, parse, false>(result, dataset, stop_flag);
+    } else {
+        parse_schema_tuples_into<Schema, parse, true>(result, dataset, stop_flag);
+    }
+}
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "bench.hpp"
+#include "kernels.hpp"
+#include "svb.hpp"
+
+namespace {
+
+// The floats and the container id, copied as they are from and to NativeTuple.
+constexpr size_t svb_fixed_size = 4 * sizeof(float) + HASH_BYTES;
+static_assert(offsetof(NativeTuple, container_id) + HASH_BYTES - offsetof(NativeTuple, load) ==
+              svb_fixed_size);
+
+uint64_t zigzag_encode(uint64_t delta) {
+    return (delta << 1U) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63U);
+}
+
+uint64_t zigzag_decode(uint64_t value) {
+    return (value >> 1U) ^ (~(value & 1U) + 1);
+}
+
+// 1 for 0, like every varint
+size_t varint_size(uint64_t value) {
+    return std::max<size_t>(1, (std::bit_width(value) + 7) / 8);
+}
+
+}  // namespace
+
+// A tuple is one control byte, id and timestamp as little-endian integers of 1 to 8 bytes each
+// (Stream-VByte style: their sizes are in the control byte, not spread over the data), then the
+// floats and the container id as in NativeTuple. The timestamp is stored zigzag-encoded relative
+// to TIMESTAMP_EPOCH_MS. Every tuple has to decode on its own (runs wrap around, pipeline chunks
+// and compressed blocks start anywhere), so there is no delta against the previous tuple.
+IMPL_VISIBILITY void serialize_svb(const NativeTuple& tup, std::vector<std::byte>* buf) {
+    const uint64_t timestamp = zigzag_encode(tup.timestamp - TIMESTAMP_EPOCH_MS);
+    const size_t id_size = varint_size(tup.id);
+    const size_t timestamp_size = varint_size(timestamp);
+
+    const size_t old_size = buf->size();
+    buf->resize(old_size + 1 + id_size + timestamp_size + svb_fixed_size);
+    std::byte* out = buf->data() + old_size;
+
+    *out++ = static_cast<std::byte>((id_size - 1) | (timestamp_size - 1) << 3U);
+    std::memcpy(out, &tup.id, id_size);  // little-endian host, like the native format
+    out += id_size;
+    std::memcpy(out, &timestamp, timestamp_size);
+    out += timestamp_size;
+    std::memcpy(out, &tup.load, svb_fixed_size);
+}
+
+IMPL_VISIBILITY bool parse_svb(const std::byte* __restrict__ read_ptr,
+                               tuple_size_t tup_size,
+                               NativeTuple* tup) noexcept {
+    if (unlikely(tup_size == 0)) {
+        return false;
+    }
+    const auto control = static_cast<uint8_t>(read_ptr[0]);
+    const size_t varint_bytes = (control & 7U) + (control >> 3U) + 2;
+
+    uint64_t values[2];
+    if (unlikely(!kernels.decode_varint_pair(control, read_ptr + 1, values) ||
+                 tup_size != 1 + varint_bytes + svb_fixed_size)) {
+        return false;
+    }
+    tup->id = values[0];
+    tup->timestamp = zigzag_decode(values[1]) + TIMESTAMP_EPOCH_MS;
+    std::memcpy(&tup->load, read_ptr + 1 + varint_bytes, svb_fixed_size);
+    return true;
+}
+
+// clang-format off
+template void generate_tuples<serialize_svb>(std::vector<std::byte>* memory, size_t target_memory_size, std::vector<tuple_size_t>* tuple_sizes, const GeneratorOptions& options);
+template void parse_tuples<parse_svb>(ThreadResult* result, const DatasetView& dataset, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+
+template void serialize_tuples<serialize_svb>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
+template void roundtrip_tuples<serialize_svb, parse_svb>(ThreadResult* result, std::span<const NativeTuple> tuples, const ParseOptions& options, const std::atomic<bool>& stop_flag);
@@ -0,0 +1,305 @@
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#ifdef BENCH_HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+#include "topology.hpp"
+
+namespace {
+
+std::string read_sysfs(const std::filesystem::path& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+size_t read_sysfs_number(const std::filesystem::path& path, size_t fallback) {
+    const std::string line = read_sysfs(path);
+    size_t value = fallback;
+    std::from_chars(line.data(), line.data() + line.size(), value);
+    return value;
+}
+
+void* allocate_on_node(size_t size, [[maybe_unused]] size_t node) {
+#ifdef BENCH_HAVE_LIBNUMA
+    if (numa_supported()) {
+        // numa_alloc_onnode binds the pages to the node, no matter which thread touches them first.
+        void* ptr = numa_alloc_onnode(size, static_cast<int>(node));
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+#endif
+    return ::operator new(size);
+}
+
+void free_on_node(void* ptr, [[maybe_unused]] size_t size) {
+    if (ptr == nullptr) {
+        return;
+    }
+#ifdef BENCH_HAVE_LIBNUMA
+    if (numa_supported()) {
+        numa_free(ptr, size);
+        return;
+    }
+#endif
+    ::operator delete(ptr);
+}
+
+}  // namespace
+
+bool numa_supported() {
+#ifdef BENCH_HAVE_LIBNUMA
+    static const bool supported = numa_available() >= 0;
+    return supported;
+#else
+    return false;
+#endif
+}
+
+size_t numa_node_count() {
+#ifdef BENCH_HAVE_LIBNUMA
+    if (numa_supported()) {
+        return static_cast<size_t>(numa_num_configured_nodes());
+    }
+#endif
+    return 1;
+}
+
+void bind_current_thread_to_numa_node([[maybe_unused]] size_t node) {
+#ifdef BENCH_HAVE_LIBNUMA
+    if (numa_supported()) {
+        numa_run_on_node(static_cast<int>(node));
+        numa_set_preferred(static_cast<int>(node));
+    }
+#endif
+}
+
+NodeLocalDataset::NodeLocalDataset(const DatasetView& source, size_t node)
+    : memory_size_(source.memory.size()), tuple_count_(source.tuple_sizes.size()), node_(node) {
+    memory_ = static_cast<std::byte*>(allocate_on_node(memory_size_ + MEMORY_PADDING, node));
+    tuple_sizes_ =
+        static_cast<tuple_size_t*>(allocate_on_node(tuple_count_ * sizeof(tuple_size_t), node));
+
+    std::copy(source.memory.begin(), source.memory.end(), memory_);
+    std::fill_n(memory_ + memory_size_, MEMORY_PADDING, std::byte{0});
+    std::copy(source.tuple_sizes.begin(), source.tuple_sizes.end(), tuple_sizes_);
+}
+
+NodeLocalDataset::~NodeLocalDataset() {
+    free_on_node(memory_, memory_size_ + MEMORY_PADDING);
+    free_on_node(tuple_sizes_, tuple_count_ * sizeof(tuple_size_t));
+}
+
+NodeLocalDataset::NodeLocalDataset(NodeLocalDataset&& other) noexcept
+    : memory_(std::exchange(other.memory_, nullptr)),
+      memory_size_(other.memory_size_),
+      tuple_sizes_(std::exchange(other.tuple_sizes_, nullptr)),
+      tuple_count_(other.tuple_count_),
+      node_(other.node_) {}
+
+NodeLocalDataset& NodeLocalDataset::operator=(NodeLocalDataset&& other) noexcept {
+    std::swap(memory_, other.memory_);
+    std::swap(memory_size_, other.memory_size_);
+    std::swap(tuple_sizes_, other.tuple_sizes_);
+    std::swap(tuple_count_, other.tuple_count_);
+    std::swap(node_, other.node_);
+    return *this;
+}
+
+DatasetView NodeLocalDataset::view() const {
+    return {std::span<const std::byte>(memory_, memory_size_),
+            std::span<const tuple_size_t>(tuple_sizes_, tuple_count_)};
+}
+
+std::vector<size_t> parse_cpu_list(std::string_view list) {
+    std::vector<size_t> cpus;
+    const auto invalid = [&] {
+        return std::runtime_error(fmt::format("Invalid CPU list: {}", list));
+    };
+    const auto parse_number = [&](std::string_view number) {
+        size_t value = 0;
+        const char* const number_end = number.data() + number.size();
+        const auto [end, error] = std::from_chars(number.data(), number_end, value);
+        if (error != std::errc() || end != number_end || number.empty()) {
+            throw invalid();
+        }
+        return value;
+    };
+
+    while (!list.empty() && list.back() == '\n') {
+        list.remove_suffix(1);
+    }
+    size_t position = 0;
+    while (position <= list.size() && !list.empty()) {
+        const size_t comma = std::min(list.find(',', position), list.size());
+        const std::string_view range = list.substr(position, comma - position);
+        const size_t dash = range.find('-');
+        if (dash == std::string_view::npos) {
+            cpus.push_back(parse_number(range));
+        } else {
+            const size_t first = parse_number(range.substr(0, dash));
+            const size_t last = parse_number(range.substr(dash + 1));
+            if (last < first) {
+                throw invalid();
+            }
+            for (size_t cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        position = comma + 1;
+    }
+    if (cpus.empty()) {
+        throw invalid();
+    }
+    return cpus;
+}
+
+CpuTopology CpuTopology::detect() {
+    namespace fs = std::filesystem;
+    const fs::path cpu_root = "/sys/devices/system/cpu";
+
+    std::vector<size_t> online;
+    try {
+        online = parse_cpu_list(read_sysfs(cpu_root / "online"));
+    } catch (const std::runtime_error&) {
+        for (size_t cpu = 0; cpu < std::max(1U, std::thread::hardware_concurrency()); ++cpu) {
+            online.push_back(cpu);
+        }
+    }
+
+    CpuTopology topology;
+    std::map<std::pair<size_t, std::string>, size_t> core_indices;  // (package, siblings) -> core
+    std::map<std::string, size_t> llc_indices;                       // shared_cpu_list -> llc
+
+    for (const size_t cpu : online) {
+        const fs::path cpu_path = cpu_root / fmt::format("cpu{}", cpu);
+        CpuInfo info{cpu, 0, 0, 0, 0, 0};
+        info.package = read_sysfs_number(cpu_path / "topology" / "physical_package_id", 0);
+
+        // Hardware threads of a core share the sibling list, so it identifies the core.
+        std::string siblings = read_sysfs(cpu_path / "topology" / "thread_siblings_list");
+        if (siblings.empty()) {
+            siblings = std::to_string(cpu);
+        }
+        const auto [core_it, core_inserted] =
+            core_indices.try_emplace({info.package, siblings}, core_indices.size());
+        info.core = core_it->second;
+        try {
+            const auto sibling_cpus = parse_cpu_list(siblings);
+            info.smt_index = static_cast<size_t>(
+                std::find(begin(sibling_cpus), end(sibling_cpus), cpu) - begin(sibling_cpus));
+        } catch (const std::runtime_error&) {
+            info.smt_index = 0;
+        }
+
+        // The last level cache is the cache index with the highest level.
+        std::string llc_cpus = siblings;
+        size_t llc_level = 0;
+        std::error_code error;
+        for (const auto& entry : fs::directory_iterator(cpu_path / "cache", error)) {
+            if (entry.path().filename().string().rfind("index", 0) != 0) {
+                continue;
+            }
+            const size_t level = read_sysfs_number(entry.path() / "level", 0);
+            if (level > llc_level) {
+                llc_level = level;
+                llc_cpus = read_sysfs(entry.path() / "shared_cpu_list");
+            }
+        }
+        const auto [llc_it, llc_inserted] = llc_indices.try_emplace(llc_cpus, llc_indices.size());
+        info.llc = llc_it->second;
+        if (llc_inserted) {
+            topology.llc_cpu_lists_.push_back(llc_cpus);
+        }
+
+        for (const auto& entry : fs::directory_iterator(cpu_path, error)) {
+            const std::string name = entry.path().filename().string();
+            if (name.rfind("node", 0) == 0) {
+                std::from_chars(name.data() + 4, name.data() + name.size(), info.numa_node);
+            }
+        }
+
+        topology.smt_width_ = std::max(topology.smt_width_, info.smt_index + 1);
+        topology.cpus_.push_back(info);
+    }
+
+    std::vector<size_t> packages;
+    for (const auto& info : topology.cpus_) {
+        packages.push_back(info.package);
+    }
+    std::sort(begin(packages), end(packages));
+    topology.package_count_ =
+        static_cast<size_t>(std::unique(begin(packages), end(packages)) - begin(packages));
+    topology.core_count_ = core_indices.size();
+    return topology;
+}
+
+const CpuInfo* CpuTopology::find(size_t cpu) const {
+    const auto it = std::find_if(begin(cpus_), end(cpus_),
+                                 [&](const CpuInfo& info) { return info.cpu == cpu; });
+    return it == end(cpus_) ? nullptr : &*it;
+}
+
+std::vector<size_t> cpu_order_for_policy(const CpuTopology& topology, std::string_view policy) {
+    std::vector<CpuInfo> cpus = topology.cpus();
+
+    if (policy == "compact" || policy == "cores") {
+        std::sort(begin(cpus), end(cpus), [](const CpuInfo& a, const CpuInfo& b) {
+            return std::tie(a.package, a.core, a.smt_index) <
+                   std::tie(b.package, b.core, b.smt_index);
+        });
+        if (policy == "cores") {
+            // The lowest online thread of every core, which is not always the first one.
+            cpus.erase(std::unique(begin(cpus), end(cpus),
+                                   [](const CpuInfo& a, const CpuInfo& b) {
+                                       return a.core == b.core;
+                                   }),
+                       end(cpus));
+        }
+    } else if (policy == "scatter") {
+        // Rank of every core within its package, so the n-th cores of all packages come together.
+        // Every core gets one, even if its first hardware thread is offline.
+        std::map<size_t, size_t> core_ranks;
+        std::map<size_t, size_t> cores_per_package;
+        for (const auto& info : cpus) {
+            if (core_ranks.count(info.core) == 0) {
+                core_ranks[info.core] = cores_per_package[info.package]++;
+            }
+        }
+        std::sort(begin(cpus), end(cpus), [&](const CpuInfo& a, const CpuInfo& b) {
+            return std::make_tuple(a.smt_index, core_ranks.at(a.core), a.package) <
+                   std::make_tuple(b.smt_index, core_ranks.at(b.core), b.package);
+        });
+    } else {
+        const std::vector<size_t> list = parse_cpu_list(policy);
+        for (const size_t cpu : list) {
+            if (topology.find(cpu) == nullptr) {
+                throw std::runtime_error(fmt::format("CPU {} is not online", cpu));
+            }
+        }
+        return list;
+    }
+
+    std::vector<size_t> order;
+    order.reserve(cpus.size());
+    for (const auto& info : cpus) {
+        order.push_back(info.cpu);
+    }
+    return order;
+}
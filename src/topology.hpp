@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench.hpp"
+
+// NUMA helpers. Without libnuma (BENCH_HAVE_LIBNUMA undefined) the machine is treated as a single
+// node and binding is a no-op.
+
+[[nodiscard]] bool numa_supported();
+[[nodiscard]] size_t numa_node_count();
+
+// Restricts the calling thread to the CPUs of `node` and prefers allocations from its memory.
+void bind_current_thread_to_numa_node(size_t node);
+
+// Copy of a dataset in the memory of one NUMA node, including MEMORY_PADDING slack.
+class NodeLocalDataset {
+   public:
+    NodeLocalDataset(const DatasetView& source, size_t node);
+    ~NodeLocalDataset();
+
+    NodeLocalDataset(const NodeLocalDataset&) = delete;
+    NodeLocalDataset& operator=(const NodeLocalDataset&) = delete;
+    NodeLocalDataset(NodeLocalDataset&& other) noexcept;
+    NodeLocalDataset& operator=(NodeLocalDataset&& other) noexcept;
+
+    [[nodiscard]] DatasetView view() const;
+    [[nodiscard]] size_t node() const { return node_; }
+
+   private:
+    std::byte* memory_ = nullptr;
+    size_t memory_size_ = 0;
+    tuple_size_t* tuple_sizes_ = nullptr;
+    size_t tuple_count_ = 0;
+    size_t node_ = 0;
+};
+
+// CPU topology as reported by /sys/devices/system/cpu.
+struct CpuInfo {
+    size_t cpu;
+    size_t package;
+    size_t core;       // unique over the whole machine, not only within the package
+    size_t smt_index;  // position among the hardware threads of the core
+    size_t llc;        // index of the last level cache shared with other CPUs
+    size_t numa_node;
+};
+
+class CpuTopology {
+   public:
+    static CpuTopology detect();
+
+    [[nodiscard]] const std::vector<CpuInfo>& cpus() const { return cpus_; }
+    [[nodiscard]] const CpuInfo* find(size_t cpu) const;
+
+    [[nodiscard]] size_t package_count() const { return package_count_; }
+    [[nodiscard]] size_t core_count() const { return core_count_; }
+    [[nodiscard]] size_t llc_count() const { return llc_cpu_lists_.size(); }
+    [[nodiscard]] size_t smt_width() const { return smt_width_; }
+    [[nodiscard]] const std::vector<std::string>& llc_cpu_lists() const { return llc_cpu_lists_; }
+
+   private:
+    std::vector<CpuInfo> cpus_;
+    size_t package_count_ = 0;
+    size_t core_count_ = 0;
+    size_t smt_width_ = 0;
+    std::vector<std::string> llc_cpu_lists_;
+};
+
+// Order in which threads are placed on CPUs: thread i runs on the i-th CPU (modulo the length).
+//  compact: fill all hardware threads of a core, then the next core of the same package.
+//  scatter: round robin over the packages, one hardware thread per core until all cores are used.
+//  cores:   like compact, but only the lowest online hardware thread of every core.
+//  anything else is a CPU list like "0,2,4-7".
+// Throws std::runtime_error for invalid lists or CPUs that are not online.
+std::vector<size_t> cpu_order_for_policy(const CpuTopology& topology, std::string_view policy);
+
+// "0-3,8" -> {0, 1, 2, 3, 8}. Throws std::runtime_error on malformed input.
+std::vector<size_t> parse_cpu_list(std::string_view list);
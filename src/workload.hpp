@@ -0,0 +1,71 @@
+#pragma once
+
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+// Value distributions of the generated tuples. The digit counts of the text formats follow from
+// these, and so does much of the number parsing cost.
+
+enum class IdDistribution {
+    uniform,     // uniform over all 64 bits: 19-20 digits
+    small,       // uniform below SMALL_ID_LIMIT, like host or container numbers
+    sequential,  // the tuple index
+};
+
+enum class TimestampDistribution {
+    uniform,    // uniform over all 64 bits
+    monotonic,  // milliseconds since the epoch, one sample every TIMESTAMP_INTERVAL_MS plus jitter
+};
+
+enum class LoadDistribution {
+    unit,       // load and load averages uniform in [0, 1)
+    realistic,  // CPU utilization in percent, load averages of a machine with up to 16 cores
+};
+
+enum class FloatFormat {
+    fixed,         // {:f}: always 6 decimals
+    shortest,      // shortest representation that parses back to the same float
+    two_decimals,  // {:.2f}, the values are rounded to two decimals when generated
+};
+
+struct WorkloadProfile {
+    IdDistribution ids = IdDistribution::uniform;
+    TimestampDistribution timestamps = TimestampDistribution::uniform;
+    LoadDistribution loads = LoadDistribution::unit;
+    FloatFormat floats = FloatFormat::fixed;
+};
+
+constexpr uint64_t SMALL_ID_LIMIT = 10000;
+constexpr uint64_t TIMESTAMP_EPOCH_MS = 1'600'000'000'000;  // 2020-09-13
+constexpr uint64_t TIMESTAMP_INTERVAL_MS = 10;
+
+// How the text serializers print floats. Set once before any tuple is serialized, to the float
+// format of the profile the tuples were generated with.
+inline FloatFormat text_float_format = FloatFormat::fixed;
+
+// Float printed in text_float_format.
+struct TextFloat {
+    float value;
+};
+
+template <>
+struct fmt::formatter<TextFloat> {
+    [[nodiscard]] static constexpr auto parse(const format_parse_context& ctx)
+        -> decltype(ctx.begin()) {
+        return ctx.begin();
+    }
+
+    template <typename FormatContext>
+    auto format(TextFloat number, FormatContext& ctx) const  // NOLINT(runtime/references)
+        -> decltype(ctx.out()) {
+        switch (text_float_format) {
+            case FloatFormat::shortest:
+                return fmt::format_to(ctx.out(), FMT_COMPILE("{}"), number.value);
+            case FloatFormat::two_decimals:
+                return fmt::format_to(ctx.out(), FMT_COMPILE("{:.2f}"), number.value);
+            case FloatFormat::fixed:
+            default:
+                return fmt::format_to(ctx.out(), FMT_COMPILE("{:f}"), number.value);
+        }
+    }
+};